@@ -8,7 +8,14 @@
 // Cyan:    \u001b[36m
 // White:   \u001b[37m
 // Reset:   \u001b[0m
-#define SUCCESS(x)  std::cout << "\033[0;35mSUCCESS: " << x << "\033[0m" << std::endl
-#define FAILED(x) std::cout << "\033[0;34mFAILED: " << x << "\033[0m" << std::endl
-#define DOC(x) std::cout << "\n\033[31;1;4m" << x << "\033[0m" << std::endl
+//
+// Examples may define COMMON_OUT, before including this file, to send
+// these to some other std::ostream
+//
+#ifndef COMMON_OUT
+#define COMMON_OUT std::cout
+#endif
+#define SUCCESS(x)  COMMON_OUT << "\033[0;35mSUCCESS: " << x << "\033[0m" << std::endl
+#define FAILED(x) COMMON_OUT << "\033[0;34mFAILED: " << x << "\033[0m" << std::endl
+#define DOC(x) COMMON_OUT << "\n\033[31;1;4m" << x << "\033[0m" << std::endl
 
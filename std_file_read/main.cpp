@@ -1,13 +1,21 @@
 #include "../common/common.h"
+#include <algorithm> // std::min
 #include <cassert>
 #include <fstream>
 #include <iomanip>
 #include <ios>
 #include <iostream>
 #include <iterator>
+#include <ranges>
 #include <sstream>
+#include <string_view>
 #include <vector>
 
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
 static const std::string filename = "tmp.txt";
 static const std::string msg      = "Time is an illusion.\n  Lunch time, doubly so.\n\n    Douglas Adams";
 
@@ -106,6 +114,119 @@ static void file_read_method4_getline(void)
   }
 }
 
+////////////////////////////////////////////////////////////////////////////
+// Map the whole file into memory and hand out its lines as std::string_view
+// slices of that mapping. Nothing is copied; the kernel pages the file in
+// as we walk it, and MADV_SEQUENTIAL tells it to read ahead aggressively
+// and drop pages behind us.
+////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+public:
+  MappedFile(const std::string &filename)
+  {
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    //
+    // A zero length file cannot be mapped, but is still a valid (empty) file
+    //
+    if ((fstat(fd, &st) < 0) || ! st.st_size) {
+      return;
+    }
+    auto addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      fd = -1;
+      return;
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+    data = static_cast< const char * >(addr);
+    size = st.st_size;
+  }
+  ~MappedFile()
+  {
+    if (data) {
+      munmap(const_cast< char * >(data), size);
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  MappedFile(const MappedFile &)            = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool             is_open(void) const { return fd >= 0; }
+  std::string_view contents(void) const { return std::string_view(data, size); }
+
+  //
+  // Walks the mapping a line at a time, splitting like std::getline does:
+  // the newline is not included and a trailing newline does not produce
+  // an extra empty line.
+  //
+  class LineIterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = std::string_view;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const std::string_view *;
+    using reference         = const std::string_view &;
+
+    LineIterator() = default;
+    LineIterator(std::string_view rest) : rest(rest) { find_line(); }
+    LineIterator &operator++()
+    {
+      rest.remove_prefix(std::min(line.size() + 1, rest.size()));
+      find_line();
+      return *this;
+    }
+    LineIterator operator++(int)
+    {
+      auto temp(*this);
+      ++*this;
+      return temp;
+    }
+    //
+    // C++20 writes a != b as ! (a == b) for us
+    //
+    bool      operator==(const LineIterator &o) const { return rest.data() == o.rest.data(); }
+    reference operator*() const { return line; }
+
+  private:
+    void find_line(void) { line = rest.substr(0, rest.find('\n')); }
+
+    std::string_view rest;
+    std::string_view line;
+  };
+
+  LineIterator begin() const { return LineIterator(contents()); }
+  LineIterator end() const { return LineIterator(contents().substr(size)); }
+
+private:
+  int         fd {-1};
+  const char *data {};
+  size_t      size {};
+};
+
+//
+// Checked at compile time, so std::ranges algorithms and views accept it
+//
+static_assert(std::forward_iterator< MappedFile::LineIterator >);
+static_assert(std::ranges::forward_range< MappedFile >);
+
+static void file_read_method5_mmap(void)
+{
+  MappedFile infile(filename);
+  if (infile.is_open()) {
+    for (auto line : infile) {
+      std::cout << line << std::endl;
+    }
+  }
+}
+
 // See
 // https://stackoverflow.com/questions/14092847/is-there-any-reason-why-the-stream-cout-has-the-flag-stdios-baseskipws-set
 static void show_ios_base_flags(void)
@@ -170,5 +291,8 @@ int main(void)
   DOC("Method 4 (via getline, line at a time, likely fast)");
   file_read_method4_getline();
 
+  DOC("Method 5 (via mmap, line at a time as std::string_view, no copies)");
+  file_read_method5_mmap();
+
   DOC("End");
 }
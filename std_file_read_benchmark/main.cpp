@@ -0,0 +1,335 @@
+#include "../common/common.h"
+#include <algorithm> // std::min
+#include <chrono>
+#include <cstdio>  // std::remove
+#include <cstdlib> // std::strtod
+#include <fstream>
+#include <iomanip> // std::setprecision
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>        // open, posix_fadvise
+#include <sys/mman.h>     // mmap, madvise
+#include <sys/resource.h> // getrusage
+#include <sys/stat.h>     // fstat
+#include <sys/wait.h>     // waitpid
+#include <unistd.h>       // fork, pipe
+
+////////////////////////////////////////////////////////////////////////////
+// The read methods from std_file_read, minus the printing. Each returns the
+// number of bytes it consumed so the compiler cannot throw the work away,
+// and so we can see when a method stops early.
+////////////////////////////////////////////////////////////////////////////
+
+//
+// How far into the file a stream got, counting any whitespace operator>>
+// skipped over
+//
+static size_t stream_position(std::ifstream &infile)
+{
+  infile.clear();
+  auto pos = infile.tellg();
+  return pos < 0 ? 0 : (size_t) pos;
+}
+
+static size_t file_read_method1_string_at_a_time(const std::string &filename)
+{
+  size_t        bytes = 0;
+  std::ifstream infile(filename, std::ios::in);
+  if (infile.is_open()) {
+    while (infile.good()) {
+      std::string s;
+      infile >> s;
+      bytes += s.size();
+    }
+    bytes = stream_position(infile);
+  }
+  return bytes;
+}
+
+static size_t file_read_method1_string_at_a_time_noskipws(const std::string &filename)
+{
+  size_t        bytes = 0;
+  std::ifstream infile(filename, std::ios::in);
+  if (infile.is_open()) {
+    infile >> std::resetiosflags(std::ios_base::skipws);
+    while (infile.good()) {
+      std::string s;
+      infile >> s;
+      bytes += s.size();
+    }
+    bytes = stream_position(infile);
+  }
+  return bytes;
+}
+
+static size_t file_read_method2_via_copy(const std::string &filename)
+{
+  std::ifstream infile(filename, std::ios::in);
+  if (infile.is_open()) {
+    std::vector< char > data;
+    std::copy(std::istream_iterator< char >(infile), std::istream_iterator< char >(), std::back_inserter(data));
+    return data.empty() ? 0 : stream_position(infile);
+  }
+  return 0;
+}
+
+static size_t file_read_method3_via_istreambuf(const std::string &filename)
+{
+  std::ifstream infile(filename, std::ios::in);
+  if (infile.is_open()) {
+    std::vector< char > data(std::istreambuf_iterator< char >(infile), {});
+    return data.size();
+  }
+  return 0;
+}
+
+static size_t file_read_method4_getline(const std::string &filename)
+{
+  size_t        bytes = 0;
+  std::string   line;
+  std::ifstream infile(filename, std::ios::in);
+  if (infile.is_open()) {
+    while (infile.good() && std::getline(infile, line)) {
+      bytes += line.size() + ! infile.eof();
+    }
+  }
+  return bytes;
+}
+
+static size_t file_read_method5_mmap(const std::string &filename)
+{
+  size_t bytes = 0;
+  auto   fd    = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat st;
+  if ((fstat(fd, &st) == 0) && st.st_size) {
+    auto addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      std::string_view rest(static_cast< const char * >(addr), st.st_size);
+      while (! rest.empty()) {
+        auto line = rest.substr(0, rest.find('\n'));
+        auto used = std::min(line.size() + 1, rest.size());
+        bytes += used;
+        rest.remove_prefix(used);
+      }
+      munmap(addr, st.st_size);
+    }
+  }
+  close(fd);
+  return bytes;
+}
+
+struct ReadMethod {
+  std::string name;
+  size_t (*fn)(const std::string &);
+};
+
+static const std::vector< ReadMethod > methods = {
+    {"method1a_string_at_a_time", file_read_method1_string_at_a_time},
+    {"method1b_string_at_a_time_noskipws", file_read_method1_string_at_a_time_noskipws},
+    {"method2_via_copy", file_read_method2_via_copy},
+    {"method3_via_istreambuf", file_read_method3_via_istreambuf},
+    {"method4_getline", file_read_method4_getline},
+    {"method5_mmap", file_read_method5_mmap},
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Write size bytes of log like text lines of varying length.
+////////////////////////////////////////////////////////////////////////////
+static void file_generate(const std::string &filename, size_t size)
+{
+  static const char *words[] = {"Time", "is", "an", "illusion.", "Lunch", "time,", "doubly", "so.", "Douglas", "Adams"};
+
+  std::string block;
+  unsigned    seed = 1;
+  while (block.size() < 64 * 1024) {
+    seed     = seed * 1103515245 + 12345;
+    auto len = 2 + (seed >> 16) % 16;
+    for (unsigned w = 0; w < len; w++) {
+      block += words[ (seed >> (w % 16)) % 10 ];
+      block += (w + 1 < len) ? " " : "\n";
+    }
+  }
+
+  std::ofstream outfile(filename, std::ios::out | std::ios::binary);
+  for (size_t written = 0; written < size; written += block.size()) {
+    outfile.write(block.data(), std::min(block.size(), size - written));
+  }
+  outfile.close();
+
+  //
+  // Make sure it is all on disk so that a cold read can drop it from the cache
+  //
+  auto fd = open(filename.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+}
+
+//
+// Ask the kernel to forget any cached pages of this file. Returns false if
+// this platform cannot do that, in which case there is no cold run.
+//
+static bool file_evict_from_cache(const std::string &filename)
+{
+#ifdef POSIX_FADV_DONTNEED
+  auto fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  auto ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  close(fd);
+  return ok;
+#else
+  return false;
+#endif
+}
+
+//
+// Read system calls made by this process so far, or -1 if unknown.
+//
+static long read_syscalls(void)
+{
+  std::ifstream io("/proc/self/io");
+  std::string   key;
+  long          value;
+  while (io >> key >> value) {
+    if (key == "syscr:") {
+      return value;
+    }
+  }
+  return -1;
+}
+
+struct Result {
+  double seconds;
+  long   syscalls;
+  long   major_faults;
+  long   peak_rss_kb;
+  size_t bytes;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Run one method in a child process, so that peak RSS and syscall counts
+// belong to that method alone and not to everything that ran before it.
+////////////////////////////////////////////////////////////////////////////
+static bool bench_one(const ReadMethod &m, const std::string &filename, Result &result)
+{
+  int fds[ 2 ];
+  if (pipe(fds) < 0) {
+    return false;
+  }
+
+  auto pid = fork();
+  if (pid < 0) {
+    close(fds[ 0 ]);
+    close(fds[ 1 ]);
+    return false;
+  }
+
+  if (! pid) {
+    close(fds[ 0 ]);
+    Result r {};
+    //
+    // Reading /proc/self/io is itself a read, so measure that and take it off
+    //
+    auto overhead = read_syscalls();
+    overhead      = read_syscalls() - overhead;
+    auto syscalls = read_syscalls();
+    auto start    = std::chrono::steady_clock::now();
+    r.bytes       = m.fn(filename);
+    r.seconds     = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    r.syscalls    = syscalls < 0 ? -1 : read_syscalls() - syscalls - overhead;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    r.major_faults = usage.ru_majflt;
+#ifdef __APPLE__
+    r.peak_rss_kb = usage.ru_maxrss / 1024;
+#else
+    r.peak_rss_kb = usage.ru_maxrss;
+#endif
+    auto ok = write(fds[ 1 ], &r, sizeof(r)) == sizeof(r);
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[ 1 ]);
+  auto ok = read(fds[ 0 ], &result, sizeof(result)) == sizeof(result);
+  close(fds[ 0 ]);
+
+  int status;
+  waitpid(pid, &status, 0);
+  return ok && WIFEXITED(status) && ! WEXITSTATUS(status);
+}
+
+//
+// Parse sizes like 1M, 512K, 10G or plain bytes
+//
+static size_t parse_size(const std::string &s)
+{
+  char *end;
+  auto  n = std::strtod(s.c_str(), &end);
+  switch (*end) {
+    case 'k' :
+    case 'K' : n *= 1024; break;
+    case 'm' :
+    case 'M' : n *= 1024 * 1024; break;
+    case 'g' :
+    case 'G' : n *= 1024 * 1024 * 1024; break;
+  }
+  return (size_t) n;
+}
+
+int main(int argc, char *argv[])
+{
+  std::vector< std::string > sizes = {"1M", "16M"};
+  if (argc > 1) {
+    sizes.assign(argv + 1, argv + argc);
+  }
+
+  DOC("Benchmark every read method, cold (page cache dropped) then warm:");
+  std::cout << "method,size_bytes,cache,mb_per_sec,read_syscalls,major_faults,peak_rss_kb,bytes_consumed,status"
+            << std::endl;
+
+  for (const auto &s : sizes) {
+    auto size     = parse_size(s);
+    auto filename = "bench_" + s + ".txt";
+    file_generate(filename, size);
+
+    for (const auto &m : methods) {
+      for (auto cache : {"cold", "warm"}) {
+        if ((std::string(cache) == "cold") && ! file_evict_from_cache(filename)) {
+          continue;
+        }
+        Result r;
+        if (! bench_one(m, filename, r)) {
+          FAILED(m.name << " " << s);
+          continue;
+        }
+        //
+        // A method that stopped short did not read the file, so it gets no
+        // rate at all rather than one for work it never did
+        //
+        std::cout << m.name << "," << size << "," << cache << ",";
+        if (r.bytes == size) {
+          std::cout << std::fixed << std::setprecision(1) << r.bytes / r.seconds / (1024 * 1024);
+        }
+        std::cout << "," << r.syscalls << "," << r.major_faults << "," << r.peak_rss_kb << "," << r.bytes << ","
+                  << (r.bytes == size ? "complete" : "incomplete") << std::endl;
+      }
+    }
+
+    std::remove(filename.c_str());
+  }
+
+  DOC("End");
+}
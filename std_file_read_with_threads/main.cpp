@@ -0,0 +1,291 @@
+#include "../common/common.h"
+#include <algorithm> // std::min
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>  // std::remove
+#include <cstdlib> // std::atol
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+enum class LineOrder { ORDERED, UNORDERED };
+
+////////////////////////////////////////////////////////////////////////////
+// Map a file into memory and split it into byte ranges, each ending just
+// after a newline, so that every range holds only whole lines. The ranges
+// are then split into lines by a pool of threads.
+////////////////////////////////////////////////////////////////////////////
+class ParallelLineReader
+{
+public:
+  using Callback = std::function< void(size_t chunk, std::string_view line) >;
+
+  ParallelLineReader(const std::string &filename, size_t nthreads = std::thread::hardware_concurrency())
+      : nthreads(std::max< size_t >(nthreads, 1))
+  {
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) < 0) || ! st.st_size) {
+      return;
+    }
+    auto addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      fd = -1;
+      return;
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+    data = static_cast< const char * >(addr);
+    size = st.st_size;
+    split_chunks();
+  }
+  ~ParallelLineReader()
+  {
+    if (data) {
+      munmap(const_cast< char * >(data), size);
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  ParallelLineReader(const ParallelLineReader &)            = delete;
+  ParallelLineReader &operator=(const ParallelLineReader &) = delete;
+
+  bool   is_open(void) const { return fd >= 0; }
+  size_t chunk_count(void) const { return chunks.size(); }
+
+  //
+  // UNORDERED: the callback is invoked from the worker threads as soon as
+  // each line is found, so it must be thread safe. Lines within a chunk
+  // arrive in order; chunks arrive in any order.
+  //
+  // ORDERED: workers find the lines, but the callback is invoked on the
+  // calling thread, in file order. Workers run at most a few chunks ahead
+  // of the caller so memory use stays bounded.
+  //
+  void for_each_line(LineOrder order, const Callback &callback) const
+  {
+    if (order == LineOrder::UNORDERED) {
+      for_each_line_unordered(callback);
+    } else {
+      for_each_line_ordered(callback);
+    }
+  }
+
+private:
+  void split_chunks(void)
+  {
+    //
+    // A few chunks per thread, so one slow chunk does not hold everyone up,
+    // but not so small that the per chunk overhead starts to matter.
+    //
+    static const size_t min_chunk_size = 1024 * 1024;
+    auto                nchunks        = std::max< size_t >(1, std::min(nthreads * 4, size / min_chunk_size));
+
+    std::string_view contents(data, size);
+    size_t           start = 0;
+    for (size_t i = 1; i <= nchunks && start < size; i++) {
+      size_t end = size;
+      if (i < nchunks) {
+        auto nl = contents.find('\n', std::max(start, size * i / nchunks));
+        end     = (nl == std::string_view::npos) ? size : nl + 1;
+      }
+      chunks.push_back(contents.substr(start, end - start));
+      start = end;
+    }
+  }
+
+  //
+  // Split like std::getline: the newline is not part of the line and a
+  // trailing newline does not make an extra empty line.
+  //
+  template < class F > static void split_lines(std::string_view chunk, F &&f)
+  {
+    while (! chunk.empty()) {
+      auto line = chunk.substr(0, chunk.find('\n'));
+      f(line);
+      chunk.remove_prefix(std::min(line.size() + 1, chunk.size()));
+    }
+  }
+
+  void for_each_line_unordered(const Callback &callback) const
+  {
+    std::atomic< size_t > next {0};
+
+    auto worker = [ & ]() {
+      for (size_t i; (i = next++) < chunks.size();) {
+        split_lines(chunks[ i ], [ & ](std::string_view line) { callback(i, line); });
+      }
+    };
+
+    std::vector< std::thread > pool;
+    for (size_t t = 0; t < nthreads; t++) {
+      pool.emplace_back(worker);
+    }
+    for (auto &t : pool) {
+      t.join();
+    }
+  }
+
+  void for_each_line_ordered(const Callback &callback) const
+  {
+    auto                                           window = nthreads * 2;
+    std::vector< std::vector< std::string_view > > lines(chunks.size());
+    std::vector< bool >                            done(chunks.size());
+    std::mutex                                     my_mutex;
+    std::condition_variable                        my_condition_var;
+    size_t                                         next      = 0;
+    size_t                                         delivered = 0;
+
+    auto worker = [ & ]() {
+      for (;;) {
+        size_t i;
+        {
+          std::unique_lock< std::mutex > my_lock(my_mutex);
+          my_condition_var.wait(my_lock, [ & ] { return next >= chunks.size() || next < delivered + window; });
+          if (next >= chunks.size()) {
+            return;
+          }
+          i = next++;
+        }
+        split_lines(chunks[ i ], [ & ](std::string_view line) { lines[ i ].push_back(line); });
+        {
+          std::lock_guard< std::mutex > my_lock(my_mutex);
+          done[ i ] = true;
+        }
+        my_condition_var.notify_all();
+      }
+    };
+
+    std::vector< std::thread > pool;
+    for (size_t t = 0; t < nthreads; t++) {
+      pool.emplace_back(worker);
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+      {
+        std::unique_lock< std::mutex > my_lock(my_mutex);
+        my_condition_var.wait(my_lock, [ & ] { return done[ i ]; });
+      }
+      for (auto line : lines[ i ]) {
+        callback(i, line);
+      }
+      std::vector< std::string_view >().swap(lines[ i ]);
+      {
+        std::lock_guard< std::mutex > my_lock(my_mutex);
+        delivered++;
+      }
+      my_condition_var.notify_all();
+    }
+
+    for (auto &t : pool) {
+      t.join();
+    }
+  }
+
+  size_t                          nthreads;
+  int                             fd {-1};
+  const char                     *data {};
+  size_t                          size {};
+  std::vector< std::string_view > chunks;
+};
+
+static const std::string filename = "tmp.txt";
+static const std::string msg      = " Time is an illusion. Lunch time, doubly so. Douglas Adams\n";
+
+static void file_write(size_t nlines)
+{
+  std::ofstream outfile(filename, std::ios::out);
+  for (size_t i = 0; i < nlines; i++) {
+    outfile << i << msg;
+  }
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+  size_t nlines = 1000 * 1000;
+  if (argc > 1) {
+    nlines = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Create a file of " << nlines << " numbered lines");
+  file_write(nlines);
+
+  DOC("Read it with getline on one thread");
+  {
+    auto          start = std::chrono::steady_clock::now();
+    size_t        count = 0;
+    std::string   line;
+    std::ifstream infile(filename, std::ios::in);
+    while (infile.good() && std::getline(infile, line)) {
+      count++;
+    }
+    std::cout << "lines " << count << " in " << (int) elapsed_ms(start) << "ms" << std::endl;
+  }
+
+  ParallelLineReader reader(filename);
+  if (! reader.is_open()) {
+    FAILED("could not open " << filename);
+    return 1;
+  }
+
+  DOC("Read it in parallel, unordered; count lines per chunk to avoid sharing a counter");
+  {
+    auto                  start = std::chrono::steady_clock::now();
+    std::vector< size_t > counts(reader.chunk_count());
+    reader.for_each_line(LineOrder::UNORDERED, [ & ](size_t chunk, std::string_view) { counts[ chunk ]++; });
+    size_t count = 0;
+    for (auto c : counts) {
+      count += c;
+    }
+    std::cout << "lines " << count << " in " << (int) elapsed_ms(start) << "ms" << std::endl;
+    if (count == nlines) {
+      SUCCESS("all lines seen");
+    } else {
+      FAILED("expected " << nlines << " lines");
+    }
+  }
+
+  DOC("Read it in parallel, ordered; check the line numbers come back in sequence");
+  {
+    auto   start    = std::chrono::steady_clock::now();
+    size_t expected = 0;
+    bool   in_order = true;
+    reader.for_each_line(LineOrder::ORDERED, [ & ](size_t, std::string_view line) {
+      size_t n = 0;
+      for (auto c : line.substr(0, line.find(' '))) {
+        n = n * 10 + (c - '0');
+      }
+      in_order &= (n == expected++);
+    });
+    std::cout << "lines " << expected << " in " << (int) elapsed_ms(start) << "ms" << std::endl;
+    if (in_order && (expected == nlines)) {
+      SUCCESS("all lines seen in order");
+    } else {
+      FAILED("lines out of order or missing");
+    }
+  }
+
+  std::remove(filename.c_str());
+
+  DOC("End");
+}
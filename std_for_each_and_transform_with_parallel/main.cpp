@@ -0,0 +1,260 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib> // std::atol
+#ifdef WITH_STD_EXECUTION
+#include <execution>
+#endif
+#include <iomanip> // std::setw
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// A chunked parallel backend for for_each and transform.
+//
+// The range is cut into chunks of consecutive elements. Each thread takes
+// the next chunk off a shared atomic counter, runs the plain serial
+// algorithm over it, and comes back for another, until none are left.
+//
+// - consecutive elements keep each thread on memory of its own, so
+//   threads do not fight over cache lines
+// - several chunks per thread mean a thread that gets easy records does
+//   not sit idle while another is still busy
+// - taking a chunk is one atomic add, so there is no lock anywhere
+//
+// Like the std::execution policies, an exception thrown by f on another
+// thread ends in std::terminate.
+////////////////////////////////////////////////////////////////////////////
+class ChunkedParallel
+{
+private:
+  //
+  // Below this, threads cost more than they save
+  //
+  static constexpr size_t serial_cutoff   = 1 << 14;
+  static constexpr size_t min_chunk       = 1 << 12;
+  static constexpr size_t chunks_a_thread = 8;
+
+  size_t nthreads;
+
+public:
+  ChunkedParallel(size_t nthreads = std::thread::hardware_concurrency()) : nthreads(std::max(nthreads, (size_t) 1))
+  {
+  }
+
+  //
+  // Call body(begin, end) for every chunk [begin, end) of [0, n)
+  //
+  template < class Body > void run(size_t n, Body body) const
+  {
+    if ((nthreads == 1) || (n < serial_cutoff)) {
+      body(0, n);
+      return;
+    }
+
+    auto                  chunk = std::max(min_chunk, n / (nthreads * chunks_a_thread));
+    std::atomic< size_t > next {0};
+    auto                  worker = [ & ]() {
+      for (;;) {
+        auto begin = next.fetch_add(chunk, std::memory_order_relaxed);
+        if (begin >= n) {
+          return;
+        }
+        body(begin, std::min(n, begin + chunk));
+      }
+    };
+
+    std::vector< std::thread > threads;
+    for (size_t t = 1; t < nthreads; t++) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+};
+
+//
+// Like std::for_each, but spread across threads
+//
+template < class Iter, class F >
+void parallel_for_each(Iter first, Iter last, F f, size_t nthreads = std::thread::hardware_concurrency())
+{
+  static_assert(std::random_access_iterator< Iter >, "chunks need random access iterators");
+  ChunkedParallel(nthreads).run(last - first, [ & ](size_t begin, size_t end) {
+    std::for_each(first + begin, first + end, f);
+  });
+}
+
+//
+// Like std::transform, but spread across threads. out must already have
+// room for every result; a std::back_inserter cannot be shared by threads.
+//
+template < class Iter, class OutIter, class F >
+OutIter parallel_transform(Iter first, Iter last, OutIter out, F f,
+                           size_t nthreads = std::thread::hardware_concurrency())
+{
+  static_assert(std::random_access_iterator< Iter >, "chunks need random access iterators");
+  static_assert(std::random_access_iterator< OutIter >, "chunks need random access iterators");
+  size_t n = last - first;
+  ChunkedParallel(nthreads).run(n, [ & ](size_t begin, size_t end) {
+    std::transform(first + begin, first + end, out + begin, f);
+  });
+  return out + n;
+}
+
+//
+// The two stages of our pipeline. The first works in place and never
+// allocates; the second makes a new string for every record.
+//
+static void upper_case(std::string &s)
+{
+  for (auto &c : s) {
+    c = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+  }
+}
+
+static std::string tag(const std::string &s) { return s + " is modified via std::transform"; }
+
+static std::vector< std::string > records(size_t n)
+{
+  std::vector< std::string > v(n);
+  for (size_t i = 0; i < n; i++) {
+    v[ i ] = "record-" + std::to_string(i);
+  }
+  return v;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const std::string &name, double for_each_ms, double transform_ms)
+{
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << for_each_ms << " ms for_each" << std::setw(10) << transform_ms << " ms transform" << std::endl;
+}
+
+//
+// Run both stages over one container, then check the last record
+//
+template < class Container, class ForEach, class Transform >
+static void bench(const std::string &name, Container in, Container out, ForEach for_each, Transform transform)
+{
+  auto start = std::chrono::steady_clock::now();
+  for_each(in);
+  auto for_each_ms = elapsed_ms(start);
+
+  start = std::chrono::steady_clock::now();
+  transform(in, out);
+  auto transform_ms = elapsed_ms(start);
+
+  report(name, for_each_ms, transform_ms);
+
+  if (! in.empty() && out.back() != tag("RECORD-" + std::to_string(in.size() - 1))) {
+    FAILED(name << " got " << out.back());
+  }
+}
+
+static void benchmark(size_t n, size_t nthreads)
+{
+  auto v = records(n);
+
+  bench(
+      "std::list, serial", std::list< std::string >(v.begin(), v.end()), std::list< std::string >(),
+      [](std::list< std::string > &l) { std::for_each(l.begin(), l.end(), upper_case); },
+      [](std::list< std::string > &l, std::list< std::string > &out) {
+        std::transform(l.begin(), l.end(), std::back_inserter(out), tag);
+      });
+
+  bench(
+      "std::vector, serial", v, std::vector< std::string >(n),
+      [](std::vector< std::string > &v) { std::for_each(v.begin(), v.end(), upper_case); },
+      [](std::vector< std::string > &v, std::vector< std::string > &out) {
+        std::transform(v.begin(), v.end(), out.begin(), tag);
+      });
+
+  bench(
+      "std::vector, ChunkedParallel", v, std::vector< std::string >(n),
+      [ & ](std::vector< std::string > &v) { parallel_for_each(v.begin(), v.end(), upper_case, nthreads); },
+      [ & ](std::vector< std::string > &v, std::vector< std::string > &out) {
+        parallel_transform(v.begin(), v.end(), out.begin(), tag, nthreads);
+      });
+
+#ifdef WITH_STD_EXECUTION
+  //
+  // upper_case neither allocates nor locks, so may be interleaved with
+  // itself on one thread (par_unseq). tag allocates, and malloc may take
+  // a lock, so it only gets to run on many threads (par).
+  //
+  bench(
+      "std::vector, std::execution", v, std::vector< std::string >(n),
+      [](std::vector< std::string > &v) { std::for_each(std::execution::par_unseq, v.begin(), v.end(), upper_case); },
+      [](std::vector< std::string > &v, std::vector< std::string > &out) {
+        std::transform(std::execution::par, v.begin(), v.end(), out.begin(), tag);
+      });
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+  const std::string                    a = "Zaphod";
+  const std::string                    b = "Marvin";
+  const std::string                    c = "The Mice";
+  std::initializer_list< std::string > i = {a, b, c};
+
+  DOC("Use parallel_for_each to modify a vector of strings");
+  {
+    std::vector< std::string > v(i);
+    parallel_for_each(v.begin(), v.end(), [](std::string &s) { s += " is modified via parallel_for_each"; });
+    for (auto e : v) {
+      std::cout << "vector-elem is " << e << std::endl;
+    }
+  }
+
+  DOC("Use parallel_transform to modify a vector of strings");
+  {
+    std::vector< std::string > v(i);
+    parallel_transform(v.begin(), v.end(), v.begin(),
+                       [](const std::string &s) { return s + " is modified via parallel_transform"; });
+    for (auto e : v) {
+      std::cout << "vector-elem is " << e << std::endl;
+    }
+  }
+
+  DOC("Use parallel_transform to write to a new vector");
+  {
+    std::vector< std::string > oldvec(i);
+    std::vector< std::string > newvec(oldvec.size());
+    parallel_transform(oldvec.begin(), oldvec.end(), newvec.begin(),
+                       [](const std::string &s) { return s + " is modified via parallel_transform"; });
+    for (auto e : oldvec) {
+      std::cout << "oldvec-elem is " << e << std::endl;
+    }
+    for (auto e : newvec) {
+      std::cout << "newvec-elem is " << e << std::endl;
+    }
+  }
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+  size_t nthreads = std::max(std::thread::hardware_concurrency(), 1U);
+  if (argc > 2) {
+    nthreads = std::atol(argv[ 2 ]);
+  }
+
+  DOC("Upper case then tag " << n << " records on " << nthreads << " thread(s)");
+  benchmark(n, nthreads);
+
+  DOC("End");
+}
@@ -0,0 +1,236 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib> // std::atol
+#include <iomanip> // std::setw
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <ranges>
+#include <string>
+#include <sys/resource.h> // getrusage
+#include <sys/wait.h>     // waitpid
+#include <unistd.h>       // fork
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// A terminal sink for a chain of views.
+//
+// Views are lazy: "range | std::views::filter(f) | std::views::transform(g)"
+// does no work at all by itself. Work happens only when something walks
+// the result, one element at a time, through every stage. into(out) is
+// that something: it walks the chain once and writes each element to out,
+// which must already have room for it, and returns where it stopped.
+////////////////////////////////////////////////////////////////////////////
+template < class OutIter > struct Into {
+  OutIter out;
+};
+
+template < class OutIter > Into< OutIter > into(OutIter out) { return Into< OutIter > {out}; }
+
+template < std::ranges::input_range R, class OutIter > OutIter operator|(R &&r, Into< OutIter > sink)
+{
+  for (auto &&e : r) {
+    *sink.out++ = std::forward< decltype(e) >(e);
+  }
+  return sink.out;
+}
+
+//
+// The stages of our pipeline. Each takes its string by value and returns
+// it, so a string made by the stage before is moved in, changed in place,
+// and moved on. Only the first stage, which copies from the source, has
+// to allocate.
+//
+static std::string upper_case(std::string s)
+{
+  for (auto &c : s) {
+    c = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+  }
+  return s;
+}
+
+static std::string add_bank(std::string s)
+{
+  s.insert(0, "galactic-bank/");
+  return s;
+}
+
+static std::string underscores(std::string s)
+{
+  std::replace(s.begin(), s.end(), '-', '_');
+  return s;
+}
+
+static std::string add_checked(std::string s)
+{
+  s += ";checked";
+  return s;
+}
+
+static bool is_open(const std::string &s) { return s.back() != '7'; }
+
+static std::vector< std::string > records(size_t n)
+{
+  std::vector< std::string > v(n);
+  for (size_t i = 0; i < n; i++) {
+    v[ i ] = "customer-" + std::to_string(i);
+  }
+  return v;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+static long peak_kb(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+//
+// Run one pipeline over the records and report how long it took, and how
+// much the peak memory of the process grew. Each run is in a child process
+// of its own, so each starts from the same peak.
+//
+template < class Pipeline >
+static void bench(const std::string &name, const std::vector< std::string > &src, const std::string &expected,
+                  Pipeline pipeline)
+{
+  std::cout.flush();
+  auto pid = fork();
+  if (pid < 0) {
+    FAILED("fork failed");
+    return;
+  }
+  if (pid > 0) {
+    int status;
+    if ((waitpid(pid, &status, 0) < 0) || ! WIFEXITED(status) || WEXITSTATUS(status)) {
+      FAILED(name << " did not run to the end");
+    }
+    return;
+  }
+
+  auto kb    = peak_kb();
+  auto start = std::chrono::steady_clock::now();
+  auto out   = pipeline(src);
+  auto ms    = elapsed_ms(start);
+  kb         = peak_kb() - kb;
+
+  std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << ms << " ms" << std::setw(10) << kb / 1024 << " MB more peak memory" << std::endl;
+  auto last = out.empty() ? std::string() : out.back();
+  if (last != expected) {
+    FAILED(name << " got " << last);
+  }
+  std::cout.flush();
+  _exit(0);
+}
+
+static void benchmark(size_t n)
+{
+  auto src = records(n);
+
+  //
+  // What the last open record comes out as, or nothing if none are open
+  //
+  std::string expected;
+  for (auto i = n; i-- > 0;) {
+    if (is_open(src[ i ])) {
+      expected = add_checked(underscores(add_bank(upper_case(src[ i ]))));
+      break;
+    }
+  }
+
+  //
+  // The way the base example does it, one whole new container per stage
+  //
+  bench("std::list, one list per stage", src, expected, [](const std::vector< std::string > &src) {
+    std::list< std::string > open, a, b, c, d;
+    std::copy_if(src.begin(), src.end(), std::back_inserter(open), is_open);
+    std::transform(open.begin(), open.end(), std::back_inserter(a), upper_case);
+    std::transform(a.begin(), a.end(), std::back_inserter(b), add_bank);
+    std::transform(b.begin(), b.end(), std::back_inserter(c), underscores);
+    std::transform(c.begin(), c.end(), std::back_inserter(d), add_checked);
+    return d;
+  });
+
+  bench("std::vector, one vector per stage", src, expected, [](const std::vector< std::string > &src) {
+    std::vector< std::string > open, a, b, c, d;
+    std::copy_if(src.begin(), src.end(), std::back_inserter(open), is_open);
+    std::transform(open.begin(), open.end(), std::back_inserter(a), upper_case);
+    std::transform(a.begin(), a.end(), std::back_inserter(b), add_bank);
+    std::transform(b.begin(), b.end(), std::back_inserter(c), underscores);
+    std::transform(c.begin(), c.end(), std::back_inserter(d), add_checked);
+    return d;
+  });
+
+  bench("views, fused into one vector", src, expected, [](const std::vector< std::string > &src) {
+    std::vector< std::string > out(src.size());
+    auto                       end = src | std::views::filter(is_open) | std::views::transform(upper_case)
+             | std::views::transform(add_bank) | std::views::transform(underscores)
+             | std::views::transform(add_checked) | into(out.begin());
+    out.erase(end, out.end());
+    return out;
+  });
+}
+
+int main(int argc, char *argv[])
+{
+  const std::string                    a = "Zaphod";
+  const std::string                    b = "Marvin";
+  const std::string                    c = "The Mice";
+  std::initializer_list< std::string > i = {a, b, c};
+
+  DOC("Chain a filter and two transforms over a list, with nothing run yet");
+  std::list< std::string > l(i);
+  auto                     pipeline = l | std::views::filter([](const std::string &s) { return s != "Marvin"; })
+                  | std::views::transform([](std::string s) { return s + " is modified"; })
+                  | std::views::transform([](std::string s) { return s + " via a view"; });
+
+  DOC("Walk the chain once, writing straight into a vector");
+  std::vector< std::string > v(l.size());
+  auto                       end = pipeline | into(v.begin());
+  v.erase(end, v.end());
+  for (auto e : v) {
+    std::cout << "vector-elem is " << e << std::endl;
+  }
+
+  DOC("The list itself is untouched");
+  for (auto e : l) {
+    std::cout << "list-elem is " << e << std::endl;
+  }
+
+  //
+  // A filter after a transform reads each element to test it, and the sink
+  // reads it again, and each read runs the transform
+  //
+  DOC("Count transform calls with the filter after the transform");
+  int  calls = 0;
+  auto count = [ & ](std::string s) {
+    calls++;
+    return s;
+  };
+  auto keep = [](const std::string &s) { return s != "Marvin"; };
+  l | std::views::transform(count) | std::views::filter(keep) | into(v.begin());
+  std::cout << calls << " calls for " << l.size() << " elements" << std::endl;
+
+  DOC("Count transform calls with the filter first");
+  calls = 0;
+  l | std::views::filter(keep) | std::views::transform(count) | into(v.begin());
+  std::cout << calls << " calls for " << l.size() << " elements" << std::endl;
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Filter " << n << " records and run four transforms on each");
+  benchmark(n);
+
+  DOC("End");
+}
@@ -0,0 +1,268 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib> // std::malloc, std::atol
+#include <cstring> // std::memcpy
+#include <iomanip> // std::setw
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// Count the times we ask the heap for memory, so we can see what each
+// way of building strings costs per element.
+////////////////////////////////////////////////////////////////////////////
+static size_t heap_allocations;
+
+void *operator new(std::size_t size)
+{
+  heap_allocations++;
+  auto p = std::malloc(size ? size : 1);
+  if (! p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  heap_allocations++;
+  return std::malloc(size ? size : 1);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+//
+// Replace the contents of out with all of pieces, one after another. The
+// total length is worked out first, so out grows at most once, and not at
+// all if it already has the room from last time.
+//
+template < class... Pieces > std::string &concat_into(std::string &out, const Pieces &...pieces)
+{
+  out.clear();
+  out.reserve((std::string_view(pieces).size() + ... + 0));
+  (out.append(pieces), ...);
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// An arena for strings that all live and die together, such as the output
+// of one batch.
+//
+// Memory comes from the heap in large blocks, and each string is carved
+// off the end of the current block, its characters right after those of
+// the string before it. So a million short strings cost a few hundred heap
+// allocations, not a million, and all of them are freed at once when the
+// arena goes away.
+//
+// Strings are built with a StringBuilder, one at a time per arena, and
+// handed out as std::string_view. Those views are good for as long as the
+// arena is.
+////////////////////////////////////////////////////////////////////////////
+class StringArena
+{
+private:
+  static constexpr size_t block_size = 64 * 1024;
+
+  std::vector< std::unique_ptr< char[] > > blocks;
+  char                                    *pos {};
+  char                                    *limit {};
+
+  friend class StringBuilder;
+
+  //
+  // Make room for n more characters after the string being built, which
+  // runs from start to pos. If the block is full, the string so far moves
+  // to the start of a new block, and start is updated to match.
+  //
+  void make_room(char *&start, size_t n)
+  {
+    if ((size_t) (limit - pos) >= n) {
+      return;
+    }
+    size_t have = pos - start;
+    size_t size = std::max(block_size, 2 * (have + n));
+    blocks.emplace_back(new char[ size ]);
+    auto block = blocks.back().get();
+    if (have) {
+      std::memcpy(block, start, have);
+    }
+    start = block;
+    pos   = block + have;
+    limit = block + size;
+  }
+
+public:
+  StringArena(void) = default;
+  StringArena(const StringArena &) = delete;
+  StringArena &operator=(const StringArena &) = delete;
+
+  size_t block_count(void) const { return blocks.size(); }
+};
+
+class StringBuilder
+{
+private:
+  StringArena &arena;
+  char        *start;
+
+public:
+  StringBuilder(StringArena &arena) : arena(arena), start(arena.pos) {}
+  StringBuilder(const StringBuilder &) = delete;
+
+  StringBuilder &append(std::string_view s)
+  {
+    arena.make_room(start, s.size());
+    if (! s.empty()) {
+      std::memcpy(arena.pos, s.data(), s.size());
+      arena.pos += s.size();
+    }
+    return *this;
+  }
+  StringBuilder &operator<<(std::string_view s) { return append(s); }
+
+  std::string_view str(void) const { return std::string_view(start, arena.pos - start); }
+};
+
+//
+// Like std::transform, but instead of returning a new string, f appends
+// its result to a StringBuilder, in place in the arena. What lands in out
+// is a std::string_view of each result.
+//
+template < class Iter, class OutIter, class F >
+OutIter transform_into(Iter first, Iter last, OutIter out, StringArena &arena, F f)
+{
+  for (; first != last; ++first) {
+    StringBuilder b(arena);
+    f(*first, b);
+    *out++ = b.str();
+  }
+  return out;
+}
+
+static std::vector< std::string > records(size_t n)
+{
+  std::vector< std::string > v(n);
+  for (size_t i = 0; i < n; i++) {
+    v[ i ] = "customer-" + std::to_string(i);
+  }
+  return v;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Run one transform over the records, and report the time and the heap
+// allocations per element it took. transform returns its last result, or
+// an empty string if there were no records.
+//
+template < class Transform >
+static void bench(const std::string &name, size_t n, const std::string &expected, Transform transform)
+{
+  auto allocations = heap_allocations;
+  auto start       = std::chrono::steady_clock::now();
+  auto last        = transform();
+  auto ms          = elapsed_ms(start);
+  allocations      = heap_allocations - allocations;
+
+  std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(1) << std::setw(8)
+            << ms << " ms" << std::setprecision(4) << std::setw(10);
+  if (n) {
+    std::cout << (double) allocations / n;
+  } else {
+    std::cout << "-";
+  }
+  std::cout << " allocations per element" << std::endl;
+  if (last != expected) {
+    FAILED(name << " got " << last);
+  }
+}
+
+static void benchmark(size_t n)
+{
+  auto src      = records(n);
+  auto expected = src.empty() ? std::string() : src.back() + " is modified via std::transform";
+
+  bench("std::transform, s + \" ...\" + \" ...\"", n, expected, [ & ]() {
+    std::vector< std::string > out(n);
+    std::transform(src.begin(), src.end(), out.begin(),
+                   [](const std::string &s) { return s + " is modified" + " via std::transform"; });
+    return out.empty() ? std::string() : out.back();
+  });
+
+  std::vector< std::string > reused(n);
+  bench("std::transform, concat_into", n, expected, [ & ]() {
+    std::transform(src.begin(), src.end(), reused.begin(), [](const std::string &s) {
+      std::string out;
+      return std::move(concat_into(out, s, " is modified", " via std::transform"));
+    });
+    return reused.empty() ? std::string() : reused.back();
+  });
+
+  //
+  // This time each output string still has the capacity it was given last
+  // time round, so nothing needs allocating
+  //
+  bench("concat_into, output reused", n, expected, [ & ]() {
+    for (size_t i = 0; i < n; i++) {
+      concat_into(reused[ i ], src[ i ], " is modified", " via std::transform");
+    }
+    return reused.empty() ? std::string() : reused.back();
+  });
+
+  StringArena arena;
+  bench("transform_into, StringArena", n, expected, [ & ]() {
+    std::vector< std::string_view > out(n);
+    transform_into(src.begin(), src.end(), out.begin(), arena,
+                   [](const std::string &s, StringBuilder &b) { b << s << " is modified" << " via std::transform"; });
+    return out.empty() ? std::string() : std::string(out.back());
+  });
+  std::cout << "the arena took " << arena.block_count() << " blocks from the heap" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  const std::string                    a = "Zaphod";
+  const std::string                    b = "Marvin";
+  const std::string                    c = "The Mice";
+  std::initializer_list< std::string > i = {a, b, c};
+
+  DOC("Use concat_into to build each string in the same buffer");
+  {
+    std::list< std::string > l(i);
+    std::string              out;
+    for (const auto &s : l) {
+      concat_into(out, s, " is modified", " via concat_into");
+      std::cout << "buffer is " << out << std::endl;
+    }
+  }
+
+  DOC("Use transform_into to build new strings in a StringArena");
+  {
+    std::list< std::string >        l(i);
+    std::vector< std::string_view > v;
+    StringArena                     arena;
+    transform_into(l.begin(), l.end(), std::back_inserter(v), arena,
+                   [](const std::string &s, StringBuilder &b) { b << s << " is modified" << " via transform_into"; });
+    for (auto e : v) {
+      std::cout << "arena-elem is " << e << std::endl;
+    }
+  }
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Append to " << n << " strings");
+  benchmark(n);
+
+  DOC("End");
+}
@@ -5,11 +5,17 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 static void backward_sort(void)
 {
+  //
+  // std::greater<> (with no type) is transparent, so find() can also take a
+  // std::string_view or const char * and compare it against the keys as is,
+  // without making a temporary std::string
+  //
   DOC("backward sorted map");
-  std::map< std::string, int, std::greater< std::string > > m;
+  std::map< std::string, int, std::greater<> > m;
 
   m[ "zaphod" ]   = 1;
   m[ "universe" ] = 2;
@@ -21,12 +27,18 @@ static void backward_sort(void)
   for (auto i : m) {
     std::cout << i.first << " " << i.second << std::endl;
   }
+
+  std::string_view name = "marvin";
+  auto             it   = m.find(name);
+  if (it != m.end()) {
+    std::cout << "found " << it->first << " " << it->second << std::endl;
+  }
 }
 
 static void forward_sort(void)
 {
   DOC("forward sorted map");
-  std::map< std::string, int, std::less< std::string > > m;
+  std::map< std::string, int, std::less<> > m;
 
   m[ "zaphod" ]   = 1;
   m[ "universe" ] = 2;
@@ -38,6 +50,12 @@ static void forward_sort(void)
   for (auto i : m) {
     std::cout << i.first << " " << i.second << std::endl;
   }
+
+  std::string_view name = "vogon";
+  auto             it   = m.find(name);
+  if (it != m.end()) {
+    std::cout << "found " << it->first << " " << it->second << std::endl;
+  }
 }
 
 static void default_sort(void)
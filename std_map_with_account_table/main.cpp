@@ -0,0 +1,344 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> // std::atol
+#include <functional>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class AccountNumber
+{
+private:
+  int val {};
+
+public:
+  AccountNumber(void) {}
+  AccountNumber(int val) : val(val) {}
+  int                  value(void) const { return val; }
+  bool                 operator<(const AccountNumber &rhs) const { return (val < rhs.val); }
+  bool                 operator==(const AccountNumber &rhs) const { return (val == rhs.val); }
+  std::string          to_string(void) const { return "AccountNumber(" + std::to_string(val) + ")"; }
+  friend std::ostream &operator<<(std::ostream &os, const AccountNumber &o)
+  {
+    os << o.to_string();
+    return os;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A table of accounts stored as a "structure of arrays". Instead of one
+// object per account holding its number, cash and flags side by side,
+// each field has a column of its own: one contiguous array of numbers,
+// one of balances, one of flags. Row i of the table is element i of
+// every column.
+//
+// A scan that only needs balances then reads only the balance column,
+// and every byte of every cache line it pulls in is a balance. Loops over
+// one column are also simple enough for the compiler to vectorize.
+////////////////////////////////////////////////////////////////////////////
+template < class T > class AccountTable
+{
+public:
+  enum Flag : uint8_t {
+    Frozen = 1 << 0,
+    Closed = 1 << 1,
+  };
+
+  //
+  // A row, as references into each column
+  //
+  struct Row {
+    const AccountNumber &number;
+    T                   &cash;
+    uint8_t             &flags;
+  };
+
+  class Iterator
+  {
+  public:
+    Iterator(AccountTable *table, size_t i) : table(table), i(i) {}
+    Row       operator*() const { return (*table)[ i ]; }
+    Iterator &operator++()
+    {
+      i++;
+      return *this;
+    }
+    bool operator==(const Iterator &o) const { return i == o.i; }
+    bool operator!=(const Iterator &o) const { return i != o.i; }
+
+  private:
+    AccountTable *table;
+    size_t        i;
+  };
+
+  Iterator begin(void) { return Iterator(this, 0); }
+  Iterator end(void) { return Iterator(this, size()); }
+  size_t   size(void) const { return numbers.size(); }
+  Row      operator[](size_t i) { return Row {numbers[ i ], balances[ i ], flag_bits[ i ]}; }
+
+  void reserve(size_t n)
+  {
+    numbers.reserve(n);
+    balances.reserve(n);
+    flag_bits.reserve(n);
+    index.reserve(n);
+  }
+
+  //
+  // Add an account and return its row, or the existing row if the account
+  // number is already in the table
+  //
+  size_t add(const AccountNumber &number, T cash, uint8_t flags = 0)
+  {
+    auto [ it, inserted ] = index.emplace(number.value(), size());
+    if (inserted) {
+      numbers.push_back(number);
+      balances.push_back(cash);
+      flag_bits.push_back(flags);
+    }
+    return it->second;
+  }
+
+  //
+  // The row of an account, or size() if there is no such account
+  //
+  size_t find(const AccountNumber &number) const
+  {
+    auto it = index.find(number.value());
+    return it == index.end() ? size() : it->second;
+  }
+
+  //
+  // Direct access to each column, for scans of your own
+  //
+  std::span< const AccountNumber > number_column(void) const { return numbers; }
+  std::span< T >                   cash_column(void) { return balances; }
+  std::span< const T >             cash_column(void) const { return balances; }
+  std::span< uint8_t >             flag_column(void) { return flag_bits; }
+
+  //
+  // Only ever reads the cash column
+  //
+  T total(void) const { return std::accumulate(balances.begin(), balances.end(), T {}); }
+
+  //
+  // The rows whose cash and flags satisfy pred(cash, flags). Only the two
+  // columns pred needs are read.
+  //
+  template < class Pred > std::vector< size_t > select(Pred pred) const
+  {
+    std::vector< size_t > rows;
+    for (size_t i = 0; i < size(); i++) {
+      if (pred(balances[ i ], flag_bits[ i ])) {
+        rows.push_back(i);
+      }
+    }
+    return rows;
+  }
+
+  //
+  // Batch deposits, skipping frozen and closed accounts
+  //
+  void deposit(const std::vector< size_t > &rows, T amount)
+  {
+    for (auto i : rows) {
+      balances[ i ] += flag_bits[ i ] ? T {} : amount;
+    }
+  }
+  void deposit_all(T amount)
+  {
+    for (size_t i = 0; i < size(); i++) {
+      balances[ i ] += flag_bits[ i ] ? T {} : amount;
+    }
+  }
+
+private:
+  std::vector< AccountNumber >      numbers;
+  std::vector< T >                  balances;
+  std::vector< uint8_t >            flag_bits;
+  std::unordered_map< int, size_t > index;
+};
+
+//
+// For comparison: the same account kept as one object, the way a node
+// container of accounts holds it. A balance scan has to step over the
+// owner, the flags and the callback of every account to reach its cash.
+//
+template < class T > struct AccountRecord {
+  AccountNumber            number;
+  T                        cash {};
+  uint8_t                  flags {};
+  std::string              owner;
+  std::function< void(T) > on_transaction;
+};
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Print the time for one scan, and how many bytes of balances per second
+// that works out at
+//
+template < class T > static void report(const std::string &name, size_t n, double ms, T total)
+{
+  auto gbs = (double) (n * sizeof(T)) / (ms / 1000.0) / 1e9;
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2) << std::setw(10)
+            << ms << " ms" << std::setw(10) << gbs << " GB/s of balances"
+            << "  total " << total << std::endl;
+}
+
+static void benchmark(size_t n)
+{
+  using Cash = int64_t;
+
+  std::mt19937                         rng(42);
+  std::uniform_int_distribution< int > cash(0, 100000);
+  std::uniform_int_distribution< int > frozen(0, 99);
+
+  std::map< AccountNumber, AccountRecord< Cash > > by_map;
+  std::vector< AccountRecord< Cash > >             by_vector;
+  AccountTable< Cash >                             table;
+  by_vector.reserve(n);
+  table.reserve(n);
+
+  for (size_t i = 0; i < n; i++) {
+    AccountRecord< Cash > r;
+    r.number = AccountNumber((int) i);
+    r.cash   = cash(rng);
+    r.flags  = frozen(rng) == 0 ? AccountTable< Cash >::Frozen : 0;
+    r.owner  = "customer-" + std::to_string(i);
+    table.add(r.number, r.cash, r.flags);
+    by_vector.push_back(r);
+    by_map.emplace(r.number, std::move(r));
+  }
+
+  DOC("End of day balance scan over " << n << " accounts");
+
+  auto start = std::chrono::steady_clock::now();
+  Cash total = 0;
+  for (const auto &acc : by_map) {
+    total += acc.second.cash;
+  }
+  report("std::map of AccountRecord", n, elapsed_ms(start), total);
+
+  start = std::chrono::steady_clock::now();
+  total = 0;
+  for (const auto &acc : by_vector) {
+    total += acc.cash;
+  }
+  report("std::vector of AccountRecord", n, elapsed_ms(start), total);
+
+  start = std::chrono::steady_clock::now();
+  total = table.total();
+  report("AccountTable::total()", n, elapsed_ms(start), total);
+
+  DOC("Find and top up every account under $100 that is not frozen");
+
+  start         = std::chrono::steady_clock::now();
+  size_t topped = 0;
+  for (auto &acc : by_map) {
+    if (acc.second.cash < 100 && ! acc.second.flags) {
+      acc.second.cash += 50;
+      topped++;
+    }
+  }
+  auto ms = elapsed_ms(start);
+  std::cout << std::left << std::setw(36) << "std::map of AccountRecord" << std::right << std::setw(10) << ms << " ms"
+            << "  topped up " << topped << std::endl;
+
+  start     = std::chrono::steady_clock::now();
+  auto rows = table.select([](Cash c, uint8_t flags) { return c < 100 && ! flags; });
+  table.deposit(rows, 50);
+  ms = elapsed_ms(start);
+  std::cout << std::left << std::setw(36) << "AccountTable select + deposit" << std::right << std::setw(10) << ms
+            << " ms  topped up " << rows.size() << std::endl;
+
+  DOC("Pay interest of $1 into every account that is not frozen");
+
+  start = std::chrono::steady_clock::now();
+  for (auto &acc : by_map) {
+    acc.second.cash += acc.second.flags ? 0 : 1;
+  }
+  ms = elapsed_ms(start);
+  std::cout << std::left << std::setw(36) << "std::map of AccountRecord" << std::right << std::setw(10) << ms << " ms"
+            << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  table.deposit_all(1);
+  ms = elapsed_ms(start);
+  std::cout << std::left << std::setw(36) << "AccountTable::deposit_all()" << std::right << std::setw(10) << ms
+            << " ms" << std::endl;
+
+  total = 0;
+  for (const auto &acc : by_map) {
+    total += acc.second.cash;
+  }
+  if (total != table.total()) {
+    FAILED("AccountTable total " << table.total() << " does not match std::map total " << total);
+  } else {
+    SUCCESS("AccountTable and std::map agree on the total " << total);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  using Table = AccountTable< int >;
+
+  DOC("Create an AccountTable of AccountNumber, cash and flags");
+  Table thebank;
+
+  auto show_all_bank_accounts = ([](Table &t) {
+    DOC("Show all bank accounts");
+    for (auto row : t) {
+      std::cout << row.number << " $" << row.cash << (row.flags & Table::Frozen ? " (frozen)" : "") << std::endl;
+    }
+  });
+
+  DOC("Load the accounts from a std::map");
+  std::map< AccountNumber, int > accounts = {{101, 10000}, {102, 20000}, {103, 50}, {104, 30000}, {105, 75}};
+  for (const auto &[ number, cash ] : accounts) {
+    thebank.add(number, cash);
+  }
+  show_all_bank_accounts(thebank);
+
+  DOC("Freeze account 105");
+  thebank[ thebank.find(105) ].flags |= Table::Frozen;
+  show_all_bank_accounts(thebank);
+
+  DOC("Does account 106 exist?");
+  if (thebank.find(106) == thebank.size()) {
+    DOC("No");
+  } else {
+    DOC("Yes");
+  }
+
+  DOC("Total cash in the bank, read from the cash column alone");
+  std::cout << "$" << thebank.total() << std::endl;
+
+  DOC("Select accounts under $100 that are not frozen and deposit $100 into each");
+  auto poor = thebank.select([](int cash, uint8_t flags) { return cash < 100 && ! flags; });
+  thebank.deposit(poor, 100);
+  show_all_bank_accounts(thebank);
+
+  DOC("Deposit $1 into every account that is not frozen");
+  thebank.deposit_all(1);
+  show_all_bank_accounts(thebank);
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+  benchmark(n);
+
+  DOC("End");
+}
@@ -0,0 +1,473 @@
+#include "../common/common.h"
+#include <algorithm> // std::lower_bound, std::stable_sort
+#include <chrono>
+#include <cstdlib> // std::malloc, std::atol
+#include <functional>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// Count the bytes we ask the heap for, so we can see what each container
+// costs per entry.
+////////////////////////////////////////////////////////////////////////////
+static size_t heap_bytes;
+
+void *operator new(std::size_t size)
+{
+  heap_bytes += size;
+  auto p = std::malloc(size ? size : 1);
+  if (! p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  heap_bytes += size;
+  return std::malloc(size ? size : 1);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+class AccountNumber
+{
+private:
+  int val {};
+
+public:
+  AccountNumber(void) {}
+  AccountNumber(int val) : val(val) {}
+  bool                 operator<(const AccountNumber &rhs) const { return (val < rhs.val); }
+  std::string          to_string(void) const { return "AccountNumber(" + std::to_string(val) + ")"; }
+  friend std::ostream &operator<<(std::ostream &os, const AccountNumber &o)
+  {
+    os << o.to_string();
+    return os;
+  }
+};
+
+template < class T > class BankAccount;
+
+template < class T > class BankAccount
+{
+private:
+  T cash {};
+
+public:
+  BankAccount() { std::cout << "default constructor " << to_string() << std::endl; }
+  BankAccount(T cash) : cash(cash) { std::cout << "new cash " << to_string() << std::endl; }
+  BankAccount(const BankAccount &o)
+  {
+    std::cout << "copy cash constructor called for " << o.to_string() << std::endl;
+    cash = o.cash;
+    std::cout << "copy cash constructor result is  " << to_string() << std::endl;
+  }
+  BankAccount &operator=(const BankAccount &o) = default;
+  ~BankAccount() { std::cout << "delete account " << to_string() << std::endl; }
+  void deposit(const T &deposit)
+  {
+    cash += deposit;
+    std::cout << "deposit cash called " << to_string() << std::endl;
+  }
+  T                    balance(void) const { return cash; }
+  friend std::ostream &operator<<(std::ostream &os, const BankAccount< T > &o)
+  {
+    os << "$" << std::to_string(o.cash);
+    return os;
+  }
+  std::string to_string(void) const
+  {
+    auto              address = static_cast< const void              *>(this);
+    std::stringstream ss;
+    ss << address;
+    return "BankAccount(" + ss.str() + ", cash $" + std::to_string(cash) + ")";
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A map kept as two sorted vectors, one of keys and one of values.
+//
+// A std::map allocates a tree node per entry and every lookup chases
+// pointers from node to node, each likely a cache miss. Here the keys sit
+// next to each other, so a lookup only touches the keys, and far fewer
+// cache lines of them. The price is that insert and erase in the middle
+// have to shuffle everything after them along, so this suits maps that
+// are built once (see the bulk load constructor) and then mostly read.
+//
+// freeze() goes one step further and keeps a second copy of the keys in
+// Eytzinger (breadth first) order: the root first, then its two children,
+// then their four, and so on. A search then walks forwards through memory
+// and the next few levels can be prefetched while we compare. Any change
+// to the map drops this copy again.
+////////////////////////////////////////////////////////////////////////////
+template < class Key, class T, class Compare = std::less< Key > > class FlatMap
+{
+public:
+  using key_type    = Key;
+  using mapped_type = T;
+  using size_type   = size_t;
+
+  //
+  // Dereferences to a std::pair of references into the two vectors,
+  // rather than to a pair stored in the map as std::map does
+  //
+  template < bool is_const > class Iterator
+  {
+  public:
+    using Map               = std::conditional_t< is_const, const FlatMap, FlatMap >;
+    using value_type        = std::pair< Key, T >;
+    using reference         = std::pair< const Key &, std::conditional_t< is_const, const T &, T & > >;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+    struct pointer {
+      reference        ref;
+      const reference *operator->() const { return &ref; }
+    };
+
+    Iterator(void) {}
+    Iterator(Map *map, size_t i) : map(map), i(i) {}
+    reference operator*() const { return reference(map->keys[ i ], map->values[ i ]); }
+    pointer   operator->() const { return pointer {**this}; }
+    Iterator &operator++()
+    {
+      i++;
+      return *this;
+    }
+    Iterator operator++(int)
+    {
+      auto tmp = *this;
+      i++;
+      return tmp;
+    }
+    bool operator==(const Iterator &o) const { return i == o.i; }
+    bool operator!=(const Iterator &o) const { return i != o.i; }
+
+  private:
+    Map   *map {};
+    size_t i {};
+  };
+
+  using iterator       = Iterator< false >;
+  using const_iterator = Iterator< true >;
+
+  FlatMap(void) {}
+
+  //
+  // Bulk load: one sort and one pass, instead of an O(n) insert per entry.
+  // As with std::map::insert, the first of any duplicate keys wins.
+  //
+  template < class InputIt > FlatMap(InputIt first, InputIt last)
+  {
+    std::vector< std::pair< Key, T > > items(first, last);
+    auto by_key = [ this ](const std::pair< Key, T > &a, const std::pair< Key, T > &b) {
+      return compare(a.first, b.first);
+    };
+    if (! std::is_sorted(items.begin(), items.end(), by_key)) {
+      std::stable_sort(items.begin(), items.end(), by_key);
+    }
+    keys.reserve(items.size());
+    values.reserve(items.size());
+    for (auto &item : items) {
+      if (! keys.empty() && ! compare(keys.back(), item.first)) {
+        continue;
+      }
+      keys.push_back(std::move(item.first));
+      values.push_back(std::move(item.second));
+    }
+  }
+
+  iterator       begin(void) { return iterator(this, 0); }
+  iterator       end(void) { return iterator(this, size()); }
+  const_iterator begin(void) const { return const_iterator(this, 0); }
+  const_iterator end(void) const { return const_iterator(this, size()); }
+  size_t         size(void) const { return keys.size(); }
+  bool           empty(void) const { return keys.empty(); }
+
+  iterator       find(const Key &key) { return iterator(this, find_index(key)); }
+  const_iterator find(const Key &key) const { return const_iterator(this, find_index(key)); }
+  size_t         count(const Key &key) const { return find_index(key) != size(); }
+
+  std::pair< iterator, bool > insert(std::pair< Key, T > value)
+  {
+    auto i = lower_bound_index(value.first);
+    if ((i < size()) && ! compare(value.first, keys[ i ])) {
+      return std::make_pair(iterator(this, i), false);
+    }
+    thaw();
+    keys.insert(keys.begin() + i, std::move(value.first));
+    values.insert(values.begin() + i, std::move(value.second));
+    return std::make_pair(iterator(this, i), true);
+  }
+
+  template < class... Args > std::pair< iterator, bool > emplace(Args &&...args)
+  {
+    return insert(std::pair< Key, T >(std::forward< Args >(args)...));
+  }
+
+  T &operator[](const Key &key)
+  {
+    auto i = lower_bound_index(key);
+    if ((i == size()) || compare(key, keys[ i ])) {
+      thaw();
+      keys.insert(keys.begin() + i, key);
+      values.insert(values.begin() + i, T());
+    }
+    return values[ i ];
+  }
+
+  size_t erase(const Key &key)
+  {
+    auto i = find_index(key);
+    if (i == size()) {
+      return 0;
+    }
+    thaw();
+    keys.erase(keys.begin() + i);
+    values.erase(values.begin() + i);
+    return 1;
+  }
+
+  void clear(void)
+  {
+    thaw();
+    keys.clear();
+    values.clear();
+  }
+
+  //
+  // Build the Eytzinger copy of the keys; call once the map is loaded
+  //
+  void freeze(void)
+  {
+    eytzinger_keys.resize(size() + 1);
+    eytzinger_index.resize(size() + 1);
+    eytzinger_build(0, 1);
+    frozen = true;
+  }
+
+private:
+  size_t lower_bound_index(const Key &key) const
+  {
+    return std::lower_bound(keys.begin(), keys.end(), key, compare) - keys.begin();
+  }
+
+  size_t find_index(const Key &key) const
+  {
+    if (frozen) {
+      return eytzinger_find(key);
+    }
+    auto i = lower_bound_index(key);
+    if ((i < size()) && ! compare(key, keys[ i ])) {
+      return i;
+    }
+    return size();
+  }
+
+  void thaw(void)
+  {
+    if (frozen) {
+      frozen = false;
+      std::vector< Key >().swap(eytzinger_keys);
+      std::vector< size_t >().swap(eytzinger_index);
+    }
+  }
+
+  //
+  // Lay the sorted keys out by an in-order walk of the implicit tree where
+  // node k has children 2k and 2k+1; slot 0 is unused
+  //
+  size_t eytzinger_build(size_t i, size_t k)
+  {
+    if (k <= size()) {
+      i                    = eytzinger_build(i, 2 * k);
+      eytzinger_keys[ k ]  = keys[ i ];
+      eytzinger_index[ k ] = i++;
+      i                    = eytzinger_build(i, 2 * k + 1);
+    }
+    return i;
+  }
+
+  size_t eytzinger_find(const Key &key) const
+  {
+    //
+    // Prefetch the keys four levels down; they share a cache line
+    //
+    static const size_t per_line = std::max< size_t >(1, 64 / sizeof(Key));
+    const Key          *tree     = eytzinger_keys.data();
+    size_t              n        = size();
+    size_t              k        = 1;
+    while (k <= n) {
+      __builtin_prefetch(tree + std::min(k * per_line, n));
+      k = 2 * k + compare(tree[ k ], key);
+    }
+    //
+    // We went right at every level after the lower bound; strip those
+    // moves (trailing 1 bits) and the last left move to get back to it
+    //
+    k >>= __builtin_ffsll(~k);
+    if (! k || compare(key, tree[ k ])) {
+      return n;
+    }
+    return eytzinger_index[ k ];
+  }
+
+  std::vector< Key >    keys;
+  std::vector< T >      values;
+  std::vector< Key >    eytzinger_keys;
+  std::vector< size_t > eytzinger_index;
+  bool                  frozen {};
+  Compare               compare;
+};
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::nano >(std::chrono::steady_clock::now() - start).count();
+}
+
+static volatile long bench_sink;
+
+template < class Map > static long bench_lookups(const std::string &name, const Map &m, const std::vector< int > &probes)
+{
+  auto start = std::chrono::steady_clock::now();
+  long found = 0;
+  for (auto p : probes) {
+    auto it = m.find(AccountNumber(p));
+    if (it != m.end()) {
+      found += it->second;
+    }
+  }
+  auto ns    = elapsed_ns(start);
+  bench_sink = found;
+  std::cout << std::left << std::setw(34) << name << std::right << std::setw(10) << std::fixed
+            << std::setprecision(1) << ns / probes.size() << " ns/lookup" << std::endl;
+  return found;
+}
+
+//
+// Look up random accounts in a map of naccounts, built each way
+//
+static void bench(size_t naccounts, size_t nlookups)
+{
+  std::vector< std::pair< AccountNumber, long > > accounts;
+  std::vector< int >                              probes;
+  std::mt19937                                    rng(42);
+  for (size_t i = 0; i < naccounts; i++) {
+    accounts.push_back(std::make_pair(AccountNumber((int) i * 2), (long) i));
+  }
+  std::shuffle(accounts.begin(), accounts.end(), rng);
+  for (size_t i = 0; i < nlookups; i++) {
+    probes.push_back((int) (rng() % (naccounts * 2)));
+  }
+
+  auto bytes = heap_bytes;
+  auto start = std::chrono::steady_clock::now();
+  std::map< const AccountNumber, long > tree(accounts.begin(), accounts.end());
+  auto tree_ns    = elapsed_ns(start);
+  auto tree_bytes = heap_bytes - bytes;
+
+  bytes = heap_bytes;
+  start = std::chrono::steady_clock::now();
+  FlatMap< AccountNumber, long > flat(accounts.begin(), accounts.end());
+  auto flat_ns    = elapsed_ns(start);
+  auto flat_bytes = heap_bytes - bytes;
+
+  std::cout << std::left << std::setw(34) << "std::map build" << std::right << std::setw(10) << (long) (tree_ns / 1e6)
+            << " ms, " << tree_bytes / naccounts << " bytes/account" << std::endl;
+  std::cout << std::left << std::setw(34) << "FlatMap bulk load" << std::right << std::setw(10)
+            << (long) (flat_ns / 1e6) << " ms, " << flat_bytes / naccounts << " bytes/account (peak)" << std::endl;
+
+  auto expected = bench_lookups("std::map find", tree, probes);
+  auto binary   = bench_lookups("FlatMap find (binary search)", flat, probes);
+  flat.freeze();
+  auto eytzinger = bench_lookups("FlatMap find (Eytzinger, frozen)", flat, probes);
+
+  if ((binary == expected) && (eytzinger == expected)) {
+    SUCCESS("every container found the same accounts");
+  } else {
+    FAILED("lookups disagree");
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  DOC("Create a FlatMap of AccountNumber -> Account");
+  using Account = BankAccount< int >;
+  using Bank    = FlatMap< AccountNumber, Account >;
+  Bank thebank;
+
+  auto show_all_bank_accounts = ([](const Bank &b) {
+    DOC("Show all bank accounts");
+    for (auto const &acc : b) {
+      std::cout << acc.first << " " << acc.second << std::endl;
+    }
+  });
+
+  DOC("Create some accounts");
+  AccountNumber account1(101);
+  Account       balance1(10000);
+
+  AccountNumber account2(102);
+  Account       balance2(20000);
+
+  AccountNumber account3(104);
+  Account       balance3(30000);
+
+  AccountNumber account4(103);
+  Account       balance4(40000);
+
+  DOC("Add an account with insert()");
+  thebank.insert(std::make_pair(account1, balance1));
+
+  DOC("Add an account with map[k] = v");
+  thebank[ account2 ] = balance2;
+
+  DOC("Add an account with emplace()");
+  thebank.emplace(std::make_pair(account3, balance3));
+
+  show_all_bank_accounts(thebank);
+
+  DOC("Does account4 exist?");
+  if (thebank.find(account4) == thebank.end()) {
+    DOC("No. Add it quick! It goes in the middle, so account3 is shuffled along");
+    thebank.insert(std::make_pair(account4, balance4));
+  } else {
+    DOC("Yes");
+  }
+  show_all_bank_accounts(thebank);
+
+  DOC("Freeze the bank for fast lookups. Does account1 exist?");
+  thebank.freeze();
+  if (thebank.find(account1) == thebank.end()) {
+    FAILED("No");
+  } else {
+    SUCCESS("Yes, " << thebank.find(account1)->second);
+  }
+
+  DOC("Remove account2");
+  thebank.erase(account2);
+  show_all_bank_accounts(thebank);
+
+  DOC("Modify account3");
+  thebank[ account3 ].deposit(100);
+  show_all_bank_accounts(thebank);
+
+  DOC("Rob the bank");
+  thebank.clear();
+
+  size_t naccounts = 1000 * 1000;
+  if (argc > 1) {
+    naccounts = std::atol(argv[ 1 ]);
+  }
+  DOC("Benchmark " << naccounts << " accounts, 10000000 random lookups, half of them misses");
+  bench(naccounts, 10 * 1000 * 1000);
+
+  DOC("End");
+}
@@ -0,0 +1,504 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib> // std::atol
+#include <functional>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <sys/resource.h> // getrusage
+#include <sys/wait.h>     // waitpid
+#include <thread>
+#include <type_traits>
+#include <unistd.h> // fork
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// A pool of fixed size blocks, one pool per block size.
+//
+// Each thread keeps its own free list, so allocate and deallocate are just
+// a pop or a push with no lock. When a thread's list runs dry it refills
+// from a slab: one big allocation carved up into many blocks, so the
+// blocks of a container sit next to each other in memory rather than
+// wherever the heap had room.
+//
+// A block freed on one thread goes onto that thread's list, wherever it
+// was allocated. Blocks left on a list when its thread exits go back to
+// the shared depot for other threads to reuse.
+//
+// Lifetime: slabs, and the depot itself, are never handed back to the
+// heap, not even at program exit. A container with static storage
+// duration may be destroyed after every other static and after the
+// thread_local free lists, and its nodes must still be there to free.
+// Blocks freed or allocated once a thread's list is gone go straight to
+// and from the depot, under its lock.
+////////////////////////////////////////////////////////////////////////////
+template < size_t Size, size_t Align > class FixedPool
+{
+private:
+  struct Block {
+    Block *next;
+  };
+
+  static constexpr size_t align      = std::max(Align, alignof(Block));
+  static constexpr size_t block_size = (std::max(Size, sizeof(Block)) + align - 1) / align * align;
+  static constexpr size_t slab_size  = 64 * 1024;
+  static constexpr size_t per_slab   = std::max(slab_size / block_size, (size_t) 1);
+
+  //
+  // Shared by all threads, and only locked to refill a free list
+  //
+  struct Depot {
+    std::mutex            my_mutex;
+    std::vector< void * > slabs;
+    Block                *spare {};
+  };
+
+  struct FreeList {
+    Block *head {};
+
+    ~FreeList()
+    {
+      give_back(head);
+      head        = nullptr;
+      list_gone() = true;
+    }
+  };
+
+  //
+  // Made on first use and never destroyed, see the lifetime rule above
+  //
+  static Depot &depot(void)
+  {
+    static Depot *d = new Depot;
+    return *d;
+  }
+
+  static FreeList &free_list(void)
+  {
+    thread_local FreeList f;
+    return f;
+  }
+
+  //
+  // Set once this thread's free list has been destroyed. A bool has
+  // nothing to destroy, so it can still be read after that.
+  //
+  static bool &list_gone(void)
+  {
+    thread_local bool gone = false;
+    return gone;
+  }
+
+  //
+  // Put a chain of blocks on the depot's spare list
+  //
+  static void give_back(Block *head)
+  {
+    if (! head) {
+      return;
+    }
+    auto tail = head;
+    while (tail->next) {
+      tail = tail->next;
+    }
+    auto                       &d = depot();
+    std::lock_guard< std::mutex > lock(d.my_mutex);
+    tail->next = d.spare;
+    d.spare    = head;
+  }
+
+  static void refill(FreeList &f)
+  {
+    auto                       &d = depot();
+    std::lock_guard< std::mutex > lock(d.my_mutex);
+
+    //
+    // Blocks left behind by threads that have gone come first
+    //
+    if (d.spare) {
+      f.head  = d.spare;
+      d.spare = nullptr;
+      return;
+    }
+
+    auto slab = static_cast< char * >(::operator new(per_slab * block_size, std::align_val_t(align)));
+    d.slabs.push_back(slab);
+    for (size_t i = per_slab; i-- > 0;) {
+      auto b  = reinterpret_cast< Block * >(slab + i * block_size);
+      b->next = f.head;
+      f.head  = b;
+    }
+  }
+
+  static void *pop(FreeList &f)
+  {
+    if (! f.head) {
+      refill(f);
+    }
+    auto b = f.head;
+    f.head = b->next;
+    return b;
+  }
+
+public:
+  static void *allocate(void)
+  {
+    //
+    // With this thread's list gone, borrow one for just this block. It
+    // gives the rest back to the depot as it goes.
+    //
+    if (list_gone()) {
+      FreeList f;
+      return pop(f);
+    }
+    return pop(free_list());
+  }
+
+  static void deallocate(void *p) noexcept
+  {
+    auto b = static_cast< Block * >(p);
+    if (list_gone()) {
+      b->next = nullptr;
+      give_back(b);
+      return;
+    }
+    auto &f = free_list();
+    b->next = f.head;
+    f.head  = b;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// An allocator for node based containers. std::map, std::set and friends
+// rebind it to their node type and then only ever ask for one node at a
+// time, which is what FixedPool is for. Anything else (an array of n
+// objects) goes to the normal heap.
+//
+// It has no state, so any two PoolAllocators can free each other's memory.
+// That is what lets merge() and extract() move nodes between containers.
+////////////////////////////////////////////////////////////////////////////
+template < class T > class PoolAllocator
+{
+public:
+  using value_type      = T;
+  using is_always_equal = std::true_type;
+
+  PoolAllocator(void) noexcept {}
+  template < class U > PoolAllocator(const PoolAllocator< U > &) noexcept {}
+
+  T *allocate(size_t n)
+  {
+    if (n == 1) {
+      return static_cast< T * >(FixedPool< sizeof(T), alignof(T) >::allocate());
+    }
+    return std::allocator< T >().allocate(n);
+  }
+
+  void deallocate(T *p, size_t n) noexcept
+  {
+    if (n == 1) {
+      FixedPool< sizeof(T), alignof(T) >::deallocate(p);
+    } else {
+      std::allocator< T >().deallocate(p, n);
+    }
+  }
+};
+
+template < class T, class U > bool operator==(const PoolAllocator< T > &, const PoolAllocator< U > &) { return true; }
+template < class T, class U > bool operator!=(const PoolAllocator< T > &, const PoolAllocator< U > &) { return false; }
+
+class AccountNumber
+{
+private:
+  int val {};
+
+public:
+  AccountNumber(void) {}
+  AccountNumber(int val) : val(val) {}
+  bool                 operator<(const AccountNumber &rhs) const { return (val < rhs.val); }
+  std::string          to_string(void) const { return "AccountNumber(" + std::to_string(val) + ")"; }
+  friend std::ostream &operator<<(std::ostream &os, const AccountNumber &o)
+  {
+    os << o.to_string();
+    return os;
+  }
+};
+
+template < class T > class BankAccount;
+
+template < class T > class BankAccount
+{
+private:
+  T cash {};
+
+public:
+  BankAccount() { std::cout << "default constructor " << to_string() << std::endl; }
+  BankAccount(T cash) : cash(cash) { std::cout << "new cash " << to_string() << std::endl; }
+  BankAccount(const BankAccount &o)
+  {
+    std::cout << "copy cash constructor called for " << o.to_string() << std::endl;
+    cash = o.cash;
+    std::cout << "copy cash constructor result is  " << to_string() << std::endl;
+  }
+  ~BankAccount() { std::cout << "delete account " << to_string() << std::endl; }
+  void deposit(const T &deposit)
+  {
+    cash += deposit;
+    std::cout << "deposit cash called " << to_string() << std::endl;
+  }
+  using CheckTransactionCallback = std::function< void(T) >;
+  int check_transaction(int cash, CheckTransactionCallback fn)
+  {
+    if (cash < 100) {
+      throw std::string("transaction is too small for Mr Money Bags");
+    } else {
+      fn(cash);
+    }
+    return cash;
+  }
+  T    balance(void) const { return cash; }
+  bool check_balance(T expected) const
+  {
+    if (cash == expected) {
+      return true;
+    } else {
+      throw std::string("account has different funds " + to_string() + " than expected " + std::to_string(expected));
+    }
+  }
+  friend std::ostream &operator<<(std::ostream &os, const BankAccount< T > &o)
+  {
+    os << "$" << std::to_string(o.cash);
+    return os;
+  }
+  std::string to_string(void) const
+  {
+    auto              address = static_cast< const void              *>(this);
+    std::stringstream ss;
+    ss << address;
+    return "BankAccount(" + ss.str() + ", cash $" + std::to_string(cash) + ")";
+  }
+};
+
+static void bank_demo(void)
+{
+  DOC("Create a std::map of AccountNumber -> Account, with nodes from a pool");
+  using Account = BankAccount< int >;
+  using Alloc   = PoolAllocator< std::pair< const AccountNumber, Account > >;
+  using Bank    = std::map< const AccountNumber, Account, std::less< AccountNumber >, Alloc >;
+  Bank thebank;
+
+  DOC("Add some accounts");
+  thebank.emplace(101, 10000);
+  thebank.emplace(102, 20000);
+  thebank.emplace(103, 30000);
+
+  DOC("Show all bank accounts");
+  for (auto const &acc : thebank) {
+    std::cout << acc.first << " " << acc.second << std::endl;
+  }
+
+  //
+  // All PoolAllocators are equal, so a node can move to another map with
+  // the same allocator type, without being copied
+  //
+  DOC("Move account 102 to another bank");
+  Bank otherbank;
+  otherbank.insert(thebank.extract(102));
+  for (auto const &acc : otherbank) {
+    std::cout << acc.first << " " << acc.second << std::endl;
+  }
+
+  DOC("Rob both banks");
+  thebank.clear();
+  otherbank.clear();
+}
+
+static void customer_demo(void)
+{
+  DOC("Create a std::set and std::multiset of customer names, with nodes from a pool");
+  using Names      = std::set< std::string, std::less<>, PoolAllocator< std::string > >;
+  using MultiNames = std::multiset< std::string, std::less<>, PoolAllocator< std::string > >;
+
+  Names      customers {"Arthur", "Zaphod", "Marvin"};
+  MultiNames accounts {"Zaphod", "Zaphod", "Ford"};
+
+  DOC("Merge the set into the multiset");
+  accounts.merge(customers);
+  for (const auto &name : accounts) {
+    std::cout << name << std::endl;
+  }
+}
+
+//
+// Each thread builds and tears down its own map. None of them takes a lock
+// except to grab a new slab.
+//
+static void thread_demo(void)
+{
+  DOC("Build maps on four threads at once");
+  using Map = std::map< int, int, std::less< int >, PoolAllocator< std::pair< const int, int > > >;
+
+  std::vector< std::thread > threads;
+  std::vector< size_t >      sizes(4);
+  for (size_t t = 0; t < sizes.size(); t++) {
+    threads.emplace_back([ &sizes, t ] {
+      Map m;
+      for (int i = 0; i < 100000; i++) {
+        m[ i ] = i;
+      }
+      sizes[ t ] = m.size();
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  for (auto size : sizes) {
+    if (size != 100000) {
+      FAILED("thread built a map of size " << size);
+    }
+  }
+  SUCCESS("All threads built their maps");
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+static long page_faults(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+}
+
+//
+// Build a map from shuffled keys, look every key up, then tear it down.
+// The map is made by make(), so each allocator can set it up its own way.
+// Each run is in a child process of its own, so none of them can reuse
+// memory an earlier run has already faulted in.
+//
+template < class Map, class Make, class Teardown >
+static void bench(const std::string &name, const std::vector< int > &keys, Make make, Teardown teardown)
+{
+  std::cout.flush();
+  auto pid = fork();
+  if (pid < 0) {
+    FAILED("fork failed");
+    return;
+  }
+  if (pid > 0) {
+    int status;
+    if ((waitpid(pid, &status, 0) < 0) || ! WIFEXITED(status) || WEXITSTATUS(status)) {
+      FAILED(name << " did not run to the end");
+    }
+    return;
+  }
+
+  auto faults = page_faults();
+  auto start  = std::chrono::steady_clock::now();
+  Map *m      = make();
+  for (auto k : keys) {
+    m->emplace(k, k);
+  }
+  auto build_ms = elapsed_ms(start);
+  faults        = page_faults() - faults;
+
+  start      = std::chrono::steady_clock::now();
+  long total = 0;
+  for (auto k : keys) {
+    total += m->find(k)->second;
+  }
+  auto find_ms = elapsed_ms(start);
+
+  long n = keys.size();
+  if (total != n * (n - 1) / 2) {
+    FAILED(name << " found the wrong balances");
+  }
+
+  start = std::chrono::steady_clock::now();
+  teardown(m);
+  auto teardown_ms = elapsed_ms(start);
+
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << build_ms << std::setw(10) << find_ms << std::setw(12) << teardown_ms << std::setw(12) << faults
+            << std::endl;
+  std::cout.flush();
+  _exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+  bank_demo();
+  customer_demo();
+  thread_demo();
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Benchmark a std::map of " << n << " AccountNumber -> long");
+  std::vector< int > keys(n);
+  for (size_t i = 0; i < n; i++) {
+    keys[ i ] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+  std::cout << std::left << std::setw(36) << "" << std::right << std::setw(10) << "build ms" << std::setw(10)
+            << "find ms" << std::setw(12) << "teardown ms" << std::setw(12) << "page faults" << std::endl;
+
+  {
+    using Map = std::map< AccountNumber, long >;
+    bench< Map >(
+        "std::allocator", keys, [] { return new Map; }, [](Map *m) { delete m; });
+  }
+  {
+    using Alloc = PoolAllocator< std::pair< const AccountNumber, long > >;
+    using Map   = std::map< AccountNumber, long, std::less< AccountNumber >, Alloc >;
+    bench< Map >(
+        "PoolAllocator", keys, [] { return new Map; }, [](Map *m) { delete m; });
+  }
+
+  //
+  // A monotonic arena never frees anything until it is released, all at
+  // once. deallocate() does nothing, but the map's destructor still walks
+  // every node to call it.
+  //
+  {
+    using Map = std::pmr::map< AccountNumber, long >;
+    std::pmr::monotonic_buffer_resource arena;
+    bench< Map >(
+        "pmr monotonic arena", keys, [ & ] { return new Map(&arena); },
+        [ & ](Map *m) {
+          delete m;
+          arena.release();
+        });
+  }
+
+  //
+  // If nothing in the map needs destroying, there is no need to walk it at
+  // all. Put the map itself in the arena, never run its destructor, and
+  // hand the whole arena back in one go.
+  //
+  {
+    using Map = std::pmr::map< AccountNumber, long >;
+    static_assert(std::is_trivially_destructible_v< AccountNumber > && std::is_trivially_destructible_v< long >);
+    std::pmr::monotonic_buffer_resource arena;
+    bench< Map >(
+        "pmr monotonic arena, release only", keys,
+        [ & ] { return new (arena.allocate(sizeof(Map), alignof(Map))) Map(&arena); },
+        [ & ](Map *) { arena.release(); });
+  }
+
+  DOC("End");
+}
@@ -1,35 +1,89 @@
 #include "../common/common.h"
 #include <algorithm> // std::move
 #include <iostream>
+#include <memory> // std::uninitialized_move
+#include <ratio>
 #include <sstream> // std::stringstream
 #include <string>
+#include <type_traits>
 
-template < class T > class MyVector
+template < class T, class Growth = std::ratio< 2 > > class MyVector
 {
 private:
   T     *data {};
   size_t maxlen {};
   size_t currlen {};
 
+  //
+  // Raw memory only. Elements are constructed in place as they are added
+  // so we never pay for default constructing slots we then overwrite.
+  //
+  static T *allocate(size_t n) { return n ? static_cast< T * >(::operator new(n * sizeof(T))) : nullptr; }
+
+  //
+  // Like std::move_if_noexcept, but for a whole range. If moving a T might
+  // throw we copy instead, so a failure half way through leaves the
+  // original elements untouched.
+  //
+  static void uninitialized_move_if_noexcept(T *s, T *e, T *out)
+  {
+    if constexpr (std::is_nothrow_move_constructible_v< T > || ! std::is_copy_constructible_v< T >) {
+      std::uninitialized_move(s, e, out);
+    } else {
+      std::uninitialized_copy(s, e, out);
+    }
+  }
+
+  //
+  // Move our elements into newdata (which has room for newlen) and free
+  // the old storage.
+  //
+  void relocate(T *newdata, size_t newlen)
+  {
+    uninitialized_move_if_noexcept(data, data + currlen, newdata);
+    std::destroy(data, data + currlen);
+    ::operator delete(data);
+    data   = newdata;
+    maxlen = newlen;
+  }
+
+  void reallocate(size_t newlen)
+  {
+    auto newdata = allocate(newlen);
+    try {
+      relocate(newdata, newlen);
+    } catch (...) {
+      ::operator delete(newdata);
+      throw;
+    }
+  }
+
+  size_t next_maxlen(void) const { return std::max(maxlen * Growth::num / Growth::den, maxlen + 1); }
+
 public:
   MyVector() : data(nullptr), maxlen(0), currlen(0)
   {
     std::cout << "default constructor " << to_string() << std::endl;
   }
-  MyVector(int maxlen) : data(new T[ maxlen ]), maxlen(maxlen), currlen(0)
+  MyVector(int maxlen) : data(allocate(maxlen)), maxlen(maxlen), currlen(0)
   {
     std::cout << "new " << to_string() << std::endl;
   }
   MyVector(const MyVector &o)
   {
     std::cout << "copy constructor called for " << o.to_string() << std::endl;
-    data    = new T[ o.maxlen ];
+    data = allocate(o.maxlen);
+    try {
+      std::uninitialized_copy(o.data, o.data + o.currlen, data);
+    } catch (...) {
+      ::operator delete(data);
+      throw;
+    }
     maxlen  = o.maxlen;
     currlen = o.currlen;
-    std::copy(o.data, o.data + o.maxlen, data);
     std::cout << "copy constructor result is  " << to_string() << std::endl;
   }
-  MyVector(MyVector< T > &&o)
+  MyVector(MyVector &&o)
   {
     std::cout << "std::move called for " << o.to_string() << std::endl;
     data      = o.data;
@@ -40,22 +94,64 @@ public:
     o.currlen = 0;
     std::cout << "std::move result is  " << to_string() << std::endl;
   }
-  ~MyVector() { std::cout << "delete " << to_string() << std::endl; }
-  void push_back(const T &i)
+  ~MyVector()
+  {
+    std::cout << "delete " << to_string() << std::endl;
+    std::destroy(data, data + currlen);
+    ::operator delete(data);
+  }
+  template < class... Args > T &emplace_back(Args &&...args)
   {
     if (currlen >= maxlen) {
-      maxlen *= 2;
-      auto newdata = new T[ maxlen ];
-      std::copy(data, data + currlen, newdata);
-      if (data) {
-        delete[] data;
+      //
+      // Build the new element in the new storage first; args may well
+      // refer to one of our own elements which is about to be moved.
+      //
+      auto newlen  = next_maxlen();
+      auto newdata = allocate(newlen);
+      try {
+        new (newdata + currlen) T(std::forward< Args >(args)...);
+      } catch (...) {
+        ::operator delete(newdata);
+        throw;
       }
-      data = newdata;
+      try {
+        relocate(newdata, newlen);
+      } catch (...) {
+        newdata[ currlen ].~T();
+        ::operator delete(newdata);
+        throw;
+      }
+    } else {
+      new (data + currlen) T(std::forward< Args >(args)...);
     }
-    data[ currlen++ ] = i;
+    return data[ currlen++ ];
+  }
+  void push_back(const T &i)
+  {
+    emplace_back(i);
     std::cout << "push_back called " << to_string() << std::endl;
   }
-  friend std::ostream &operator<<(std::ostream &os, const MyVector< T > &o)
+  void push_back(T &&i)
+  {
+    emplace_back(std::move(i));
+    std::cout << "push_back called " << to_string() << std::endl;
+  }
+  void reserve(size_t n)
+  {
+    if (n > maxlen) {
+      reallocate(n);
+    }
+    std::cout << "reserve called " << to_string() << std::endl;
+  }
+  void shrink_to_fit(void)
+  {
+    if (currlen < maxlen) {
+      reallocate(currlen);
+    }
+    std::cout << "shrink_to_fit called " << to_string() << std::endl;
+  }
+  friend std::ostream &operator<<(std::ostream &os, const MyVector &o)
   {
     auto s = o.data;
     auto e = o.data + o.currlen;
@@ -115,8 +211,21 @@ int main()
   vec3.push_back(15);
   std::cout << "vec3: " << vec3 << std::endl;
 
+  DOC("Reserve room up front, then trim the excess:");
+  vec3.reserve(16);
+  vec3.emplace_back(16);
+  vec3.shrink_to_fit();
+  std::cout << "vec3: " << vec3 << std::endl;
+
+  DOC("Create a vector that grows by 1.5x instead of 2x, starting from empty:");
+  MyVector< int, std::ratio< 3, 2 > > vec4;
+  for (auto i = 0; i < 5; i++) {
+    vec4.emplace_back(i);
+    std::cout << "emplace_back called " << vec4.to_string() << std::endl;
+  }
+
   DOC("Destroy the old vector, vec1. It has no invalid elems:");
   delete vec1;
 
-  DOC("End, expect vec2 and vec3 destroy:");
+  DOC("End, expect vec2, vec3 and vec4 destroy:");
 }
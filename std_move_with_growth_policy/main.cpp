@@ -0,0 +1,241 @@
+#include "../common/common.h"
+#include <algorithm> // std::copy
+#include <chrono>
+#include <cstdlib> // std::atol
+#include <iomanip> // std::setw
+#include <iostream>
+#include <memory> // std::uninitialized_move
+#include <ratio>
+#include <string>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////
+// A std::string wrapper that counts how it is constructed and assigned,
+// and how many bytes of string payload get duplicated along the way.
+////////////////////////////////////////////////////////////////////////////
+struct Counters {
+  size_t default_constructs {};
+  size_t copy_constructs {};
+  size_t move_constructs {};
+  size_t copy_assigns {};
+  size_t move_assigns {};
+  size_t bytes_copied {};
+};
+
+static Counters counters;
+
+class CountedString
+{
+public:
+  CountedString() { counters.default_constructs++; }
+  CountedString(const std::string &s) : s(s) {}
+  CountedString(const CountedString &o) : s(o.s)
+  {
+    counters.copy_constructs++;
+    counters.bytes_copied += s.size();
+  }
+  CountedString(CountedString &&o) noexcept : s(std::move(o.s)) { counters.move_constructs++; }
+  CountedString &operator=(const CountedString &o)
+  {
+    s = o.s;
+    counters.copy_assigns++;
+    counters.bytes_copied += s.size();
+    return *this;
+  }
+  CountedString &operator=(CountedString &&o) noexcept
+  {
+    s = std::move(o.s);
+    counters.move_assigns++;
+    return *this;
+  }
+
+private:
+  std::string s;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// The original MyVector growth: default construct a bigger array, then
+// copy every element across.
+////////////////////////////////////////////////////////////////////////////
+template < class T > class OldVector
+{
+private:
+  T     *data {};
+  size_t maxlen {};
+  size_t currlen {};
+
+public:
+  OldVector(int maxlen) : data(new T[ maxlen ]), maxlen(maxlen), currlen(0) {}
+  ~OldVector() { delete[] data; }
+  void push_back(const T &i)
+  {
+    if (currlen >= maxlen) {
+      maxlen *= 2;
+      auto newdata = new T[ maxlen ];
+      std::copy(data, data + currlen, newdata);
+      if (data) {
+        delete[] data;
+      }
+      data = newdata;
+    }
+    data[ currlen++ ] = i;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// The MyVector growth from std_move, without the logging: raw storage,
+// elements constructed in place and moved (if that cannot throw) on growth.
+////////////////////////////////////////////////////////////////////////////
+template < class T, class Growth = std::ratio< 2 > > class MyVector
+{
+private:
+  T     *data {};
+  size_t maxlen {};
+  size_t currlen {};
+
+  static T *allocate(size_t n) { return n ? static_cast< T * >(::operator new(n * sizeof(T))) : nullptr; }
+
+  static void uninitialized_move_if_noexcept(T *s, T *e, T *out)
+  {
+    if constexpr (std::is_nothrow_move_constructible_v< T > || ! std::is_copy_constructible_v< T >) {
+      std::uninitialized_move(s, e, out);
+    } else {
+      std::uninitialized_copy(s, e, out);
+    }
+  }
+
+  void relocate(T *newdata, size_t newlen)
+  {
+    uninitialized_move_if_noexcept(data, data + currlen, newdata);
+    std::destroy(data, data + currlen);
+    ::operator delete(data);
+    data   = newdata;
+    maxlen = newlen;
+  }
+
+  void reallocate(size_t newlen)
+  {
+    auto newdata = allocate(newlen);
+    try {
+      relocate(newdata, newlen);
+    } catch (...) {
+      ::operator delete(newdata);
+      throw;
+    }
+  }
+
+  size_t next_maxlen(void) const { return std::max(maxlen * Growth::num / Growth::den, maxlen + 1); }
+
+public:
+  MyVector() = default;
+  MyVector(const MyVector &) = delete;
+  ~MyVector()
+  {
+    std::destroy(data, data + currlen);
+    ::operator delete(data);
+  }
+  template < class... Args > T &emplace_back(Args &&...args)
+  {
+    if (currlen >= maxlen) {
+      auto newlen  = next_maxlen();
+      auto newdata = allocate(newlen);
+      try {
+        new (newdata + currlen) T(std::forward< Args >(args)...);
+      } catch (...) {
+        ::operator delete(newdata);
+        throw;
+      }
+      try {
+        relocate(newdata, newlen);
+      } catch (...) {
+        newdata[ currlen ].~T();
+        ::operator delete(newdata);
+        throw;
+      }
+    } else {
+      new (data + currlen) T(std::forward< Args >(args)...);
+    }
+    return data[ currlen++ ];
+  }
+  void push_back(const T &i) { emplace_back(i); }
+  void push_back(T &&i) { emplace_back(std::move(i)); }
+  void reserve(size_t n)
+  {
+    if (n > maxlen) {
+      reallocate(n);
+    }
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Push count strings, long enough to defeat the small string optimization,
+// and report what it cost.
+////////////////////////////////////////////////////////////////////////////
+static const std::string payload = "a string long enough to live on the heap";
+
+template < class F > static void bench(const std::string &name, size_t count, F fill)
+{
+  counters   = Counters {};
+  auto start = std::chrono::steady_clock::now();
+  fill(count);
+  auto ms = std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << std::left << std::setw(30) << name << std::right << std::setw(10) << counters.default_constructs
+            << std::setw(10) << counters.copy_constructs << std::setw(10) << counters.move_constructs
+            << std::setw(10) << counters.copy_assigns << std::setw(14) << counters.bytes_copied << std::setw(10)
+            << std::fixed << std::setprecision(0) << ms << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  size_t count = 10 * 1000 * 1000;
+  if (argc > 1) {
+    count = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Push " << count << " strings, counting constructors and bytes copied:");
+  std::cout << std::left << std::setw(30) << "container" << std::right << std::setw(10) << "default" << std::setw(10)
+            << "copy" << std::setw(10) << "move" << std::setw(10) << "copy=" << std::setw(14) << "bytes copied"
+            << std::setw(10) << "ms" << std::endl;
+
+  bench("OldVector push_back", count, [](size_t n) {
+    OldVector< CountedString > v(1);
+    CountedString              s(payload);
+    for (size_t i = 0; i < n; i++) {
+      v.push_back(s);
+    }
+  });
+
+  bench("MyVector push_back", count, [](size_t n) {
+    MyVector< CountedString > v;
+    CountedString             s(payload);
+    for (size_t i = 0; i < n; i++) {
+      v.push_back(s);
+    }
+  });
+
+  bench("MyVector 1.5x push_back", count, [](size_t n) {
+    MyVector< CountedString, std::ratio< 3, 2 > > v;
+    CountedString                                 s(payload);
+    for (size_t i = 0; i < n; i++) {
+      v.push_back(s);
+    }
+  });
+
+  bench("MyVector emplace_back", count, [](size_t n) {
+    MyVector< CountedString > v;
+    for (size_t i = 0; i < n; i++) {
+      v.emplace_back(payload);
+    }
+  });
+
+  bench("MyVector reserve+emplace_back", count, [](size_t n) {
+    MyVector< CountedString > v;
+    v.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      v.emplace_back(payload);
+    }
+  });
+
+  DOC("End");
+}
@@ -0,0 +1,282 @@
+#include "../common/common.h"
+#include <algorithm> // std::sort
+#include <chrono>
+#include <cstdlib> // std::malloc
+#include <iomanip> // std::setw
+#include <iostream>
+#include <memory> // std::uninitialized_move
+#include <new>
+#include <sstream> // std::stringstream
+#include <string>
+#include <type_traits> // std::is_nothrow_move_constructible_v
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// Count every trip to the heap so we can see what each container costs.
+////////////////////////////////////////////////////////////////////////////
+static size_t heap_allocs;
+
+void *operator new(std::size_t size)
+{
+  heap_allocs++;
+  auto p = std::malloc(size ? size : 1);
+  if (! p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+////////////////////////////////////////////////////////////////////////////
+// MyVector< T > is the heap only vector from the std_move example, minus
+// the logging. Every instance allocates, even if it only ever holds one
+// element.
+////////////////////////////////////////////////////////////////////////////
+template < class T, size_t InlineN = 0 > class MyVector;
+
+template < class T > class MyVector< T, 0 >
+{
+private:
+  T     *data {};
+  size_t maxlen {};
+  size_t currlen {};
+
+public:
+  MyVector() : data(nullptr), maxlen(0), currlen(0) {}
+  MyVector(int maxlen) : data(new T[ maxlen ]), maxlen(maxlen), currlen(0) {}
+  MyVector(const MyVector &o)
+  {
+    data    = new T[ o.maxlen ];
+    maxlen  = o.maxlen;
+    currlen = o.currlen;
+    std::copy(o.data, o.data + o.currlen, data);
+  }
+  MyVector(MyVector< T > &&o)
+  {
+    data      = o.data;
+    maxlen    = o.maxlen;
+    currlen   = o.currlen;
+    o.data    = nullptr;
+    o.maxlen  = 0;
+    o.currlen = 0;
+  }
+  ~MyVector() { delete[] data; }
+  void push_back(const T &i)
+  {
+    if (currlen >= maxlen) {
+      //
+      // Copy i in before the old storage goes; it may be one of ours
+      //
+      auto newmax  = std::max< size_t >(1, maxlen * 2);
+      auto newdata = new T[ newmax ];
+      std::copy(data, data + currlen, newdata);
+      newdata[ currlen ] = i;
+      delete[] data;
+      data   = newdata;
+      maxlen = newmax;
+    } else {
+      data[ currlen ] = i;
+    }
+    currlen++;
+  }
+  size_t   size(void) const { return currlen; }
+  const T &operator[](size_t i) const { return data[ i ]; }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// MyVector< T, InlineN > keeps the first InlineN elements inside the
+// object itself and only goes to the heap once it outgrows that.
+//
+// The inline buffer is raw memory; elements are only constructed as they
+// are pushed, so a MyVector< std::string, 4 > with one element has built
+// exactly one std::string.
+////////////////////////////////////////////////////////////////////////////
+template < class T, size_t InlineN > class MyVector
+{
+private:
+  alignas(T) unsigned char inline_data[ sizeof(T) * InlineN ];
+  T     *data {};
+  size_t maxlen {};
+  size_t currlen {};
+
+  T   *inline_ptr(void) { return reinterpret_cast< T * >(inline_data); }
+  bool is_inline(void) const { return data == reinterpret_cast< const T * >(inline_data); }
+
+  void destroy(void)
+  {
+    std::destroy(data, data + currlen);
+    if (! is_inline()) {
+      ::operator delete(data);
+    }
+  }
+
+  //
+  // Move the elements into newdata, which has room for newmax of them, and
+  // let go of the old storage
+  //
+  void relocate(T *newdata, size_t newmax)
+  {
+    std::uninitialized_move(data, data + currlen, newdata);
+    destroy();
+    data   = newdata;
+    maxlen = newmax;
+  }
+
+public:
+  MyVector() : data(inline_ptr()), maxlen(InlineN), currlen(0) {}
+  MyVector(const MyVector &o) : data(inline_ptr()), maxlen(InlineN), currlen(0)
+  {
+    if (o.currlen > InlineN) {
+      data   = static_cast< T * >(::operator new(sizeof(T) * o.currlen));
+      maxlen = o.currlen;
+    }
+    std::uninitialized_copy(o.data, o.data + o.currlen, data);
+    currlen = o.currlen;
+  }
+  MyVector(MyVector &&o) noexcept(std::is_nothrow_move_constructible_v< T >)
+      : data(inline_ptr()), maxlen(InlineN), currlen(0)
+  {
+    if (o.is_inline()) {
+      //
+      // Nothing to steal, the elements live inside the other object.
+      // Move them across one at a time.
+      //
+      std::uninitialized_move(o.data, o.data + o.currlen, data);
+      currlen = o.currlen;
+      std::destroy(o.data, o.data + o.currlen);
+    } else {
+      //
+      // Spilled to the heap; take the pointer as std_move does.
+      //
+      data    = o.data;
+      maxlen  = o.maxlen;
+      currlen = o.currlen;
+      o.data  = o.inline_ptr();
+    }
+    o.maxlen  = InlineN;
+    o.currlen = 0;
+  }
+  ~MyVector() { destroy(); }
+  void push_back(const T &i)
+  {
+    if (currlen >= maxlen) {
+      //
+      // Build the new element in the new storage first; i may well refer
+      // to one of our own elements which is about to be moved.
+      //
+      auto newmax  = maxlen * 2;
+      auto newdata = static_cast< T * >(::operator new(sizeof(T) * newmax));
+      try {
+        new (newdata + currlen) T(i);
+      } catch (...) {
+        ::operator delete(newdata);
+        throw;
+      }
+      try {
+        relocate(newdata, newmax);
+      } catch (...) {
+        newdata[ currlen ].~T();
+        ::operator delete(newdata);
+        throw;
+      }
+    } else {
+      new (data + currlen) T(i);
+    }
+    currlen++;
+  }
+  size_t   size(void) const { return currlen; }
+  const T &operator[](size_t i) const { return data[ i ]; }
+  friend std::ostream &operator<<(std::ostream &os, const MyVector &o)
+  {
+    for (size_t i = 0; i < o.currlen; i++) {
+      os << "[" << o.data[ i ] << "]";
+    }
+    return os;
+  }
+  std::string to_string(void) const
+  {
+    std::stringstream ss;
+    ss << *this;
+    return "MyVector(currlen=" + std::to_string(currlen) + ", maxlen=" + std::to_string(maxlen) +
+           (is_inline() ? ", inline" : ", heap") + " elems=" + ss.str() + ")";
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Build and tear down lots of small vectors, timing each one.
+////////////////////////////////////////////////////////////////////////////
+static const size_t bench_iterations = 200000;
+static volatile long bench_sink;
+
+template < class V > static void bench(const std::string &name, size_t n, V make)
+{
+  std::vector< double > samples;
+  samples.reserve(bench_iterations);
+
+  long checksum = 0;
+  auto allocs   = heap_allocs;
+  auto start    = std::chrono::steady_clock::now();
+
+  for (size_t iter = 0; iter < bench_iterations; iter++) {
+    auto t0 = std::chrono::steady_clock::now();
+    {
+      auto v = make();
+      for (size_t i = 0; i < n; i++) {
+        v.push_back((int) (iter + i));
+      }
+      checksum += v[ n - 1 ];
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    samples.push_back(std::chrono::duration< double, std::nano >(t1 - t0).count());
+  }
+
+  auto secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+  allocs    = heap_allocs - allocs;
+
+  std::sort(samples.begin(), samples.end());
+  auto p99 = samples[ samples.size() * 99 / 100 ];
+
+  std::cout << std::left << std::setw(22) << name << std::right << std::setw(4) << n << std::setw(12)
+            << std::fixed << std::setprecision(0) << bench_iterations / secs << std::setw(12) << std::setprecision(2)
+            << (double) allocs / bench_iterations << std::setw(14) << std::setprecision(0) << allocs / secs
+            << std::setw(10) << std::setprecision(1) << p99 << std::endl;
+  bench_sink = checksum;
+}
+
+int main()
+{
+  DOC("Create a small vector with room for 4 inline elements:");
+  MyVector< std::string, 4 > vec1;
+  vec1.push_back("elem1");
+  vec1.push_back("elem2");
+  std::cout << "vec1: " << vec1.to_string() << std::endl;
+
+  DOC("Move it; the elements are inline so they are moved one by one:");
+  auto vec2 = std::move(vec1);
+  std::cout << "vec1: " << vec1.to_string() << std::endl;
+  std::cout << "vec2: " << vec2.to_string() << std::endl;
+
+  DOC("Push past the inline limit, spilling to the heap:");
+  vec2.push_back("elem3");
+  vec2.push_back("elem4");
+  vec2.push_back("elem5");
+  std::cout << "vec2: " << vec2.to_string() << std::endl;
+
+  DOC("Move it again; this time the heap pointer is simply stolen:");
+  auto vec3 = std::move(vec2);
+  std::cout << "vec2: " << vec2.to_string() << std::endl;
+  std::cout << "vec3: " << vec3.to_string() << std::endl;
+
+  DOC("Benchmark building and destroying small vectors of int:");
+  std::cout << std::left << std::setw(22) << "container" << std::right << std::setw(4) << "n" << std::setw(12)
+            << "ops/sec" << std::setw(12) << "allocs/op" << std::setw(14) << "allocs/sec" << std::setw(10) << "p99 ns"
+            << std::endl;
+  for (size_t n : {2, 4, 8}) {
+    bench("MyVector<int>", n, []() { return MyVector< int >(1); });
+    bench("MyVector<int, 4>", n, []() { return MyVector< int, 4 >(); });
+    bench("std::vector<int>", n, []() { return std::vector< int >(); });
+  }
+
+  DOC("End");
+}
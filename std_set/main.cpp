@@ -1,11 +1,18 @@
 #include "../common/common.h"
 #include <algorithm>
+#include <chrono>
+#include <cstdlib> // std::atol
 #include <functional> // for _1, _2
+#include <iomanip> // std::setw
 #include <iostream>
+#include <iterator>
 #include <list>
+#include <random>
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 template < class T > class BankAccount;
 
@@ -82,6 +89,7 @@ public:
   }
   ~BankCustomer() { std::cout << "delete customer " << to_string() << std::endl; }
   std::string          to_string(void) const { return "Customer(" + name + ", " + account.to_string() + ")"; }
+  const std::string   &get_name(void) const { return name; }
   friend std::ostream &operator<<(std::ostream &os, const BankCustomer< T > &o)
   {
     os << o.to_string();
@@ -93,6 +101,29 @@ public:
   }
 };
 
+//
+// A transparent comparator. is_transparent tells std::set it may call us
+// with just a name, so find("Zaphod") need not build a temporary
+// BankCustomer (and std::string) to compare against. Names must sort the
+// same way as operator< above does, i.e. backwards.
+//
+struct CustomerByName {
+  using is_transparent = void;
+
+  template < class T > bool operator()(const BankCustomer< T > &lhs, const BankCustomer< T > &rhs) const
+  {
+    return lhs < rhs;
+  }
+  template < class T > bool operator()(const BankCustomer< T > &lhs, std::string_view rhs) const
+  {
+    return lhs.get_name() > rhs;
+  }
+  template < class T > bool operator()(std::string_view lhs, const BankCustomer< T > &rhs) const
+  {
+    return lhs > rhs.get_name();
+  }
+};
+
 static void backward_sort(void)
 {
   DOC("Backward sorted set");
@@ -150,7 +181,7 @@ static void account_demo(void)
   DOC("Create a std::set of BankCustomer -> Account");
   using Account  = BankAccount< int >;
   using Customer = BankCustomer< int >;
-  using TheBank  = std::set< Customer >;
+  using TheBank  = std::set< Customer, CustomerByName >;
 
   //
   // Notice, Zaphod has two accounts and the set allows both
@@ -182,23 +213,24 @@ static void account_demo(void)
 
   show_all_bank_accounts(customers);
 
-  DOC("Find Zaphod via find");
-  auto f = customers.find(Customer("Zaphod"));
+  DOC("Find Zaphod via find, by name; no temporary customer is created");
+  auto f = customers.find("Zaphod");
   if (f != customers.end()) {
     std::cout << *f << std::endl;
   }
 
   DOC("Find customers via equal_range");
   for (const auto &customer : customers) {
-    using Iter                  = std::set< Customer >::iterator;
+    using Iter                  = TheBank::iterator;
     std::pair< Iter, Iter > ret = customers.equal_range(customer);
     for (auto iter = ret.first; iter != ret.second; iter++) {
       std::cout << *iter << std::endl;
     }
   }
 
-  DOC("Get rid of a customer");
-  customers.erase(Customer("Zaphod"));
+  DOC("Get rid of a customer, by name");
+  auto zaphod = customers.equal_range("Zaphod");
+  customers.erase(zaphod.first, zaphod.second);
 
   DOC("Get rid of all customers");
   customers.clear();
@@ -206,10 +238,157 @@ static void account_demo(void)
   DOC("End");
 }
 
-int main(int, char **)
+static void bulk_demo(void)
+{
+  DOC("Bulk load a std::set of BankCustomer from a sorted range");
+  using Account  = BankAccount< int >;
+  using Customer = BankCustomer< int >;
+  using TheBank  = std::set< Customer, CustomerByName >;
+
+  //
+  // Already in the set's order, i.e. names backwards. Given a sorted range
+  // the range constructor takes linear time, as each customer is added at
+  // the end with no search down the tree.
+  //
+  std::vector< Customer > nightly;
+  nightly.reserve(4);
+  nightly.emplace_back("Zaphod", Account(100000));
+  nightly.emplace_back("Trillian", Account(5000));
+  nightly.emplace_back("Marvin", Account(0));
+  nightly.emplace_back("Arthur", Account(100));
+  if (! std::is_sorted(nightly.begin(), nightly.end(), CustomerByName())) {
+    FAILED("nightly customers are not sorted");
+  }
+  TheBank customers(nightly.begin(), nightly.end());
+
+  //
+  // A sorted batch of new customers. Each insert returns where the customer
+  // went, and the next one belongs just after it, so the hint saves the
+  // search whenever no existing customer sits in between.
+  //
+  DOC("Add a sorted batch of customers, each one hinting where the next goes");
+  std::vector< Customer > batch;
+  batch.reserve(3);
+  batch.emplace_back("Slartibartfast", Account(42));
+  batch.emplace_back("Ford", Account(10));
+  batch.emplace_back("Eddie", Account(1));
+  auto hint = customers.begin();
+  for (const auto &c : batch) {
+    hint = std::next(customers.insert(hint, c));
+  }
+
+  DOC("All customers");
+  for (const auto &b : customers) {
+    std::cout << b << std::endl;
+  }
+
+  //
+  // extract() unhooks the node from the tree, and insert() hooks it into
+  // the other one. The customer is neither copied nor reallocated.
+  //
+  DOC("Move Zaphod to another bank with extract; nothing is copied");
+  TheBank other;
+  other.insert(Customer("Marvin", Account(1)));
+  auto zaphod = customers.find("Zaphod");
+  if (zaphod != customers.end()) {
+    other.insert(customers.extract(zaphod));
+  }
+
+  //
+  // The other bank already has a Marvin, so merge leaves ours behind; a
+  // std::set cannot hold both
+  //
+  DOC("Merge the rest of the bank into the other bank; nothing is copied");
+  other.merge(customers);
+  std::cout << other.size() << " customers in the other bank, " << customers.size() << " left behind" << std::endl;
+  for (const auto &b : other) {
+    std::cout << b << std::endl;
+  }
+
+  DOC("Close both banks");
+  customers.clear();
+  other.clear();
+}
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::nano >(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const std::string &name, size_t n, size_t size, double ns)
+{
+  std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1) << std::setw(8)
+            << ns / n << " ns/insert" << std::endl;
+  if (size != n) {
+    FAILED(name << " has " << size << " elements, not " << n);
+  }
+}
+
+//
+// The ways to load n keys. Customers would print on every copy, so plain
+// ints stand in for them here.
+//
+static void bulk_load_benchmark(size_t n)
+{
+  DOC("Load " << n << " keys into a std::set");
+  std::vector< int > sorted(n);
+  for (size_t i = 0; i < n; i++) {
+    sorted[ i ] = i;
+  }
+  auto shuffled = sorted;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+  {
+    std::set< int > s;
+    auto            start = std::chrono::steady_clock::now();
+    for (auto k : shuffled) {
+      s.insert(k);
+    }
+    report("insert one at a time, shuffled", n, s.size(), elapsed_ns(start));
+  }
+  {
+    std::set< int > s;
+    auto            start = std::chrono::steady_clock::now();
+    for (auto k : sorted) {
+      s.insert(k);
+    }
+    report("insert one at a time, sorted", n, s.size(), elapsed_ns(start));
+  }
+  {
+    std::set< int > s;
+    auto            start = std::chrono::steady_clock::now();
+    for (auto k : sorted) {
+      s.insert(s.end(), k);
+    }
+    report("insert sorted, end() as the hint", n, s.size(), elapsed_ns(start));
+  }
+  {
+    auto            start = std::chrono::steady_clock::now();
+    std::set< int > s(sorted.begin(), sorted.end());
+    report("range constructor, sorted", n, s.size(), elapsed_ns(start));
+  }
+  {
+    std::set< int > from(sorted.begin(), sorted.end());
+    std::set< int > s;
+    auto            start = std::chrono::steady_clock::now();
+    while (! from.empty()) {
+      s.insert(s.end(), from.extract(from.begin()));
+    }
+    report("extract and insert, no allocation", n, s.size(), elapsed_ns(start));
+  }
+}
+
+int main(int argc, char *argv[])
 {
   backward_sort();
   forward_sort();
   default_sort();
   account_demo();
+  bulk_demo();
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+  bulk_load_benchmark(n);
 }
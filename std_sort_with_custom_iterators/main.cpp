@@ -1,66 +1,54 @@
 #include "../common/common.h"
 #include <algorithm>
+#include <compare>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 template < typename T > class MyIterator
 {
 public:
+  //
+  // iterator_concept tells C++20 algorithms the elements sit side by side
+  // in memory, so they may work on the memory directly (e.g. memmove).
+  // iterator_category is what older code looks at.
+  //
+  using iterator_concept  = std::contiguous_iterator_tag;
   using iterator_category = std::random_access_iterator_tag;
   using difference_type   = std::ptrdiff_t;
-  using value_type        = T;
+  using value_type        = std::remove_cv_t< T >;
+  using element_type      = T;
   using pointer           = T *;
   using reference         = T &;
 
   MyIterator(T *ptr = nullptr) { dataptr = ptr; }
   MyIterator(const MyIterator< T > &it) = default;
+  //
+  // An iterator can always become a const_iterator, but not the other way
+  //
+  template < typename U, typename = std::enable_if_t< std::is_convertible_v< U *, T * > > >
+  MyIterator(const MyIterator< U > &it) : dataptr(it.get_ptr())
+  {
+  }
   MyIterator< T > base()
   {
     MyIterator< T > forwardIterator(this->dataptr);
     ++forwardIterator;
     return forwardIterator;
   }
-  MyIterator< T > operator+(const difference_type &delta)
-  {
-    auto oldptr = dataptr;
-    dataptr += delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
-  }
-  MyIterator< T > operator+(int delta)
-  {
-    auto oldptr = dataptr;
-    dataptr += delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
-  }
-  MyIterator< T > operator++(int)
+  MyIterator< T > operator+(difference_type delta) const { return MyIterator< T >(dataptr + delta); }
+  friend MyIterator< T > operator+(difference_type delta, const MyIterator< T > &it) { return it + delta; }
+  MyIterator< T >        operator++(int)
   {
     auto temp(*this);
     ++dataptr;
     return temp;
   }
-  MyIterator< T > operator-(const difference_type &delta)
-  {
-    auto oldptr = dataptr;
-    dataptr -= delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
-  }
-  MyIterator< T > operator-(int delta)
-  {
-    auto oldptr = dataptr;
-    dataptr -= delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
-  }
+  MyIterator< T > operator-(difference_type delta) const { return MyIterator< T >(dataptr - delta); }
   MyIterator< T > operator--(int)
   {
     auto temp(*this);
@@ -72,7 +60,7 @@ public:
     ++dataptr;
     return (*this);
   }
-  MyIterator< T > &operator+=(const difference_type &delta)
+  MyIterator< T > &operator+=(difference_type delta)
   {
     dataptr += delta;
     return (*this);
@@ -82,7 +70,7 @@ public:
     --dataptr;
     return (*this);
   }
-  MyIterator< T > &operator-=(const difference_type &delta)
+  MyIterator< T > &operator-=(difference_type delta)
   {
     dataptr -= delta;
     return (*this);
@@ -93,15 +81,19 @@ public:
     return (*this);
   }
   MyIterator< T > &operator=(const MyIterator< T > &it) = default;
-  T               &operator*() { return *dataptr; }
-  T               *get_ptr() const { return dataptr; }
-  T               *operator->() { return dataptr; }
-  bool             operator!=(const MyIterator< T > &it) const { return (dataptr != it.get_const_ptr()); }
-  bool             operator==(const MyIterator< T > &it) const { return (dataptr == it.get_const_ptr()); }
-  const T         &operator*() const { return *dataptr; }
-  const T         *get_const_ptr() const { return dataptr; }
-  difference_type  operator-(const MyIterator< T > &it) { return std::distance(it.get_ptr(), this->get_ptr()); }
-                   operator bool() const { return dataptr != nullptr; }
+  //
+  // A const iterator is one that cannot be moved, not one whose elements
+  // cannot be changed; that is what MyIterator< const T > is for
+  //
+  T              &operator*() const { return *dataptr; }
+  T              &operator[](difference_type i) const { return dataptr[ i ]; }
+  T              *operator->() const { return dataptr; }
+  T              *get_ptr() const { return dataptr; }
+  const T        *get_const_ptr() const { return dataptr; }
+  difference_type operator-(const MyIterator< T > &it) const { return dataptr - it.dataptr; }
+  bool            operator==(const MyIterator< T > &it) const = default;
+  auto            operator<=>(const MyIterator< T > &it) const = default;
+  explicit        operator bool() const { return dataptr != nullptr; }
   ~MyIterator() {}
 
 protected:
@@ -113,33 +105,26 @@ template < typename T > class MyReverseIterator
 public:
   using iterator_category = std::random_access_iterator_tag;
   using difference_type   = std::ptrdiff_t;
-  using value_type        = T;
+  using value_type        = std::remove_cv_t< T >;
   using pointer           = T *;
   using reference         = T &;
 
   MyReverseIterator(T *ptr = nullptr) { dataptr = ptr; }
   MyReverseIterator(const MyReverseIterator< T > &it) = default;
+  template < typename U, typename = std::enable_if_t< std::is_convertible_v< U *, T * > > >
+  MyReverseIterator(const MyReverseIterator< U > &it) : dataptr(it.get_ptr())
+  {
+  }
   MyReverseIterator< T > base()
   {
     MyReverseIterator< T > forwardIterator(this->dataptr);
     ++forwardIterator;
     return forwardIterator;
   }
-  MyReverseIterator< T > operator+(const difference_type &delta)
+  MyReverseIterator< T > operator+(difference_type delta) const { return MyReverseIterator< T >(dataptr - delta); }
+  friend MyReverseIterator< T > operator+(difference_type delta, const MyReverseIterator< T > &it)
   {
-    auto oldptr = dataptr;
-    dataptr -= delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
-  }
-  MyReverseIterator< T > operator+(int delta)
-  {
-    auto oldptr = dataptr;
-    dataptr -= delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
+    return it + delta;
   }
   MyReverseIterator< T > operator++(int)
   {
@@ -147,22 +132,7 @@ public:
     --dataptr;
     return temp;
   }
-  MyReverseIterator< T > operator-(const difference_type &delta)
-  {
-    auto oldptr = dataptr;
-    dataptr += delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
-  }
-  MyReverseIterator< T > operator-(int delta)
-  {
-    auto oldptr = dataptr;
-    dataptr += delta;
-    auto temp(*this);
-    dataptr = oldptr;
-    return temp;
-  }
+  MyReverseIterator< T > operator-(difference_type delta) const { return MyReverseIterator< T >(dataptr + delta); }
   MyReverseIterator< T > operator--(int)
   {
     auto temp(*this);
@@ -174,7 +144,7 @@ public:
     --dataptr;
     return (*this);
   }
-  MyReverseIterator< T > &operator+=(const difference_type &delta)
+  MyReverseIterator< T > &operator+=(difference_type delta)
   {
     dataptr -= delta;
     return (*this);
@@ -184,7 +154,7 @@ public:
     ++dataptr;
     return (*this);
   }
-  MyReverseIterator< T > &operator-=(const difference_type &delta)
+  MyReverseIterator< T > &operator-=(difference_type delta)
   {
     dataptr += delta;
     return (*this);
@@ -195,21 +165,33 @@ public:
     return (*this);
   }
   MyReverseIterator< T > &operator=(const MyReverseIterator< T > &it) = default;
-  T                      &operator*() { return *dataptr; }
+  T                      &operator*() const { return *dataptr; }
+  T                      &operator[](difference_type i) const { return *(dataptr - i); }
+  T                      *operator->() const { return dataptr; }
   T                      *get_ptr() const { return dataptr; }
-  T                      *operator->() { return dataptr; }
-  bool            operator!=(const MyReverseIterator< T > &it) const { return (dataptr != it.get_const_ptr()); }
-  bool            operator==(const MyReverseIterator< T > &it) const { return (dataptr == it.get_const_ptr()); }
-  const T        &operator*() const { return *dataptr; }
-  const T        *get_const_ptr() const { return dataptr; }
-  difference_type operator-(const MyReverseIterator< T > &it) { return std::distance(it.get_ptr(), this->get_ptr()); }
-                  operator bool() const { return dataptr != nullptr; }
+  const T                *get_const_ptr() const { return dataptr; }
+  //
+  // The pointers run backwards, so a later reverse iterator has the lower
+  // address
+  //
+  difference_type operator-(const MyReverseIterator< T > &it) const { return it.dataptr - dataptr; }
+  bool            operator==(const MyReverseIterator< T > &it) const = default;
+  auto            operator<=>(const MyReverseIterator< T > &it) const { return it.dataptr <=> dataptr; }
+  explicit        operator bool() const { return dataptr != nullptr; }
   ~MyReverseIterator() {}
 
 protected:
   T *dataptr; // can be used by parent class, but not publically
 };
 
+//
+// Checked at compile time, so the standard algorithms are sure to accept them
+//
+static_assert(std::contiguous_iterator< MyIterator< int > >);
+static_assert(std::contiguous_iterator< MyIterator< const int > >);
+static_assert(std::random_access_iterator< MyReverseIterator< int > >);
+static_assert(std::random_access_iterator< MyReverseIterator< const int > >);
+
 template < typename T > class MyVector
 {
 private:
@@ -318,6 +300,31 @@ public:
   }
 };
 
+//
+// libstdc++ only turns std::copy into a memmove (and std::fill of bytes into
+// a memset) when it is given plain pointers. A contiguous iterator can
+// always be turned into a plain pointer with std::to_address, so do that
+// and let the standard library take its fastest path.
+//
+template < typename InIter, typename OutIter > OutIter my_copy(InIter first, InIter last, OutIter out)
+{
+  if constexpr (std::contiguous_iterator< InIter > && std::contiguous_iterator< OutIter >) {
+    std::copy(std::to_address(first), std::to_address(last), std::to_address(out));
+    return out + (last - first);
+  } else {
+    return std::copy(first, last, out);
+  }
+}
+
+template < typename Iter, typename T > void my_fill(Iter first, Iter last, const T &value)
+{
+  if constexpr (std::contiguous_iterator< Iter >) {
+    std::fill(std::to_address(first), std::to_address(last), value);
+  } else {
+    std::fill(first, last, value);
+  }
+}
+
 int main()
 {
   DOC("Create a std::initializer_list of std::string:");
@@ -345,5 +352,23 @@ int main()
     std::cout << i << std::endl;
   }
 
+  DOC("Copy into plain storage; MyIterator is contiguous, so this copies through plain pointers:");
+  std::vector< std::string > copy1(6);
+  my_copy(vec1.cbegin(), vec1.cend(), MyIterator< std::string >(copy1.data()));
+  for (const auto &i : copy1) {
+    std::cout << i << std::endl;
+  }
+
+  DOC("Fill a buffer; for bytes this is a memset:");
+  std::vector< char > buf(8);
+  my_fill(MyIterator< char >(buf.data()), MyIterator< char >(buf.data() + buf.size()), '*');
+  std::cout << std::string(buf.begin(), buf.end()) << std::endl;
+
+  DOC("C++20 range algorithms accept MyIterator too:");
+  std::ranges::sort(vec1.begin(), vec1.end());
+  for (const auto &i : vec1) {
+    std::cout << i << std::endl;
+  }
+
   DOC("End:");
 }
@@ -0,0 +1,723 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <bit> // std::bit_width
+#include <compare>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> // std::atol
+#include <cstring> // std::memcpy
+#include <functional>
+#include <initializer_list>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template < typename T > class MyIterator
+{
+public:
+  //
+  // iterator_concept tells C++20 algorithms the elements sit side by side
+  // in memory, so they may work on the memory directly (e.g. memmove).
+  // iterator_category is what older code looks at.
+  //
+  using iterator_concept  = std::contiguous_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
+  using difference_type   = std::ptrdiff_t;
+  using value_type        = std::remove_cv_t< T >;
+  using element_type      = T;
+  using pointer           = T *;
+  using reference         = T &;
+
+  MyIterator(T *ptr = nullptr) { dataptr = ptr; }
+  MyIterator(const MyIterator< T > &it) = default;
+  //
+  // An iterator can always become a const_iterator, but not the other way
+  //
+  template < typename U, typename = std::enable_if_t< std::is_convertible_v< U *, T * > > >
+  MyIterator(const MyIterator< U > &it) : dataptr(it.get_ptr())
+  {
+  }
+  MyIterator< T > base()
+  {
+    MyIterator< T > forwardIterator(this->dataptr);
+    ++forwardIterator;
+    return forwardIterator;
+  }
+  MyIterator< T > operator+(difference_type delta) const { return MyIterator< T >(dataptr + delta); }
+  friend MyIterator< T > operator+(difference_type delta, const MyIterator< T > &it) { return it + delta; }
+  MyIterator< T >        operator++(int)
+  {
+    auto temp(*this);
+    ++dataptr;
+    return temp;
+  }
+  MyIterator< T > operator-(difference_type delta) const { return MyIterator< T >(dataptr - delta); }
+  MyIterator< T > operator--(int)
+  {
+    auto temp(*this);
+    --dataptr;
+    return temp;
+  }
+  MyIterator< T > &operator++()
+  {
+    ++dataptr;
+    return (*this);
+  }
+  MyIterator< T > &operator+=(difference_type delta)
+  {
+    dataptr += delta;
+    return (*this);
+  }
+  MyIterator< T > &operator--()
+  {
+    --dataptr;
+    return (*this);
+  }
+  MyIterator< T > &operator-=(difference_type delta)
+  {
+    dataptr -= delta;
+    return (*this);
+  }
+  MyIterator< T > &operator=(T *ptr)
+  {
+    dataptr = ptr;
+    return (*this);
+  }
+  MyIterator< T > &operator=(const MyIterator< T > &it) = default;
+  //
+  // A const iterator is one that cannot be moved, not one whose elements
+  // cannot be changed; that is what MyIterator< const T > is for
+  //
+  T              &operator*() const { return *dataptr; }
+  T              &operator[](difference_type i) const { return dataptr[ i ]; }
+  T              *operator->() const { return dataptr; }
+  T              *get_ptr() const { return dataptr; }
+  const T        *get_const_ptr() const { return dataptr; }
+  difference_type operator-(const MyIterator< T > &it) const { return dataptr - it.dataptr; }
+  bool            operator==(const MyIterator< T > &it) const = default;
+  auto            operator<=>(const MyIterator< T > &it) const = default;
+  explicit        operator bool() const { return dataptr != nullptr; }
+  ~MyIterator() {}
+
+protected:
+  T *dataptr; // can be used by parent class, but not publically
+};
+
+template < typename T > class MyReverseIterator
+{
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using difference_type   = std::ptrdiff_t;
+  using value_type        = std::remove_cv_t< T >;
+  using pointer           = T *;
+  using reference         = T &;
+
+  MyReverseIterator(T *ptr = nullptr) { dataptr = ptr; }
+  MyReverseIterator(const MyReverseIterator< T > &it) = default;
+  template < typename U, typename = std::enable_if_t< std::is_convertible_v< U *, T * > > >
+  MyReverseIterator(const MyReverseIterator< U > &it) : dataptr(it.get_ptr())
+  {
+  }
+  MyReverseIterator< T > base()
+  {
+    MyReverseIterator< T > forwardIterator(this->dataptr);
+    ++forwardIterator;
+    return forwardIterator;
+  }
+  MyReverseIterator< T > operator+(difference_type delta) const { return MyReverseIterator< T >(dataptr - delta); }
+  friend MyReverseIterator< T > operator+(difference_type delta, const MyReverseIterator< T > &it)
+  {
+    return it + delta;
+  }
+  MyReverseIterator< T > operator++(int)
+  {
+    auto temp(*this);
+    --dataptr;
+    return temp;
+  }
+  MyReverseIterator< T > operator-(difference_type delta) const { return MyReverseIterator< T >(dataptr + delta); }
+  MyReverseIterator< T > operator--(int)
+  {
+    auto temp(*this);
+    ++dataptr;
+    return temp;
+  }
+  MyReverseIterator< T > &operator++()
+  {
+    --dataptr;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator+=(difference_type delta)
+  {
+    dataptr -= delta;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator--()
+  {
+    ++dataptr;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator-=(difference_type delta)
+  {
+    dataptr += delta;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator=(T *ptr)
+  {
+    dataptr = ptr;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator=(const MyReverseIterator< T > &it) = default;
+  T                      &operator*() const { return *dataptr; }
+  T                      &operator[](difference_type i) const { return *(dataptr - i); }
+  T                      *operator->() const { return dataptr; }
+  T                      *get_ptr() const { return dataptr; }
+  const T                *get_const_ptr() const { return dataptr; }
+  //
+  // The pointers run backwards, so a later reverse iterator has the lower
+  // address
+  //
+  difference_type operator-(const MyReverseIterator< T > &it) const { return it.dataptr - dataptr; }
+  bool            operator==(const MyReverseIterator< T > &it) const = default;
+  auto            operator<=>(const MyReverseIterator< T > &it) const { return it.dataptr <=> dataptr; }
+  explicit        operator bool() const { return dataptr != nullptr; }
+  ~MyReverseIterator() {}
+
+protected:
+  T *dataptr; // can be used by parent class, but not publically
+};
+
+//
+// Checked at compile time, so the standard algorithms are sure to accept them
+//
+static_assert(std::contiguous_iterator< MyIterator< int > >);
+static_assert(std::contiguous_iterator< MyIterator< const int > >);
+static_assert(std::random_access_iterator< MyReverseIterator< int > >);
+static_assert(std::random_access_iterator< MyReverseIterator< const int > >);
+
+template < typename T > class MyVector
+{
+private:
+  T     *dataptr {};
+  size_t maxlen {};
+  size_t len {};
+
+public:
+  typedef MyIterator< T >              iterator;
+  typedef MyIterator< const T >        const_iterator;
+  typedef MyReverseIterator< T >       reverse_iterator;
+  typedef MyReverseIterator< const T > const_reverse_iterator;
+
+  iterator               begin() { return iterator(&dataptr[ 0 ]); }
+  iterator               end() { return iterator(&dataptr[ len ]); }
+  const_iterator         cbegin() { return const_iterator(&dataptr[ 0 ]); }
+  const_iterator         cend() { return const_iterator(&dataptr[ len ]); }
+  reverse_iterator       rbegin() { return reverse_iterator(&dataptr[ len - 1 ]); }
+  reverse_iterator       rend() { return reverse_iterator(&dataptr[ -1 ]); }
+  const_reverse_iterator crbegin() { return const_reverse_iterator(&dataptr[ len - 1 ]); }
+  const_reverse_iterator crend() { return const_reverse_iterator(&dataptr[ -1 ]); }
+
+  MyVector() : dataptr(nullptr), maxlen(0), len(0)
+  {
+    std::cout << "default constructor " << to_string() << std::endl;
+  }
+  MyVector(int maxlen) : dataptr(new T[ maxlen ]), maxlen(maxlen), len(0)
+  {
+    std::cout << "new " << to_string() << std::endl;
+  }
+  MyVector(const MyVector &o)
+  {
+    std::cout << "copy constructor called for " << o.to_string() << std::endl;
+    dataptr = new T[ o.maxlen ];
+    maxlen  = o.maxlen;
+    len     = o.len;
+    std::copy(o.dataptr, o.dataptr + o.maxlen, dataptr);
+    std::cout << "copy constructor result is  " << to_string() << std::endl;
+  }
+  MyVector(MyVector< T > &&o)
+  {
+    std::cout << "std::move called for " << o.to_string() << std::endl;
+    dataptr   = o.dataptr;
+    maxlen    = o.maxlen;
+    len       = o.len;
+    o.dataptr = nullptr;
+    o.maxlen  = 0;
+    o.len     = 0;
+    std::cout << "std::move result is  " << to_string() << std::endl;
+  }
+  ~MyVector()
+  {
+    std::cout << "delete " << to_string() << std::endl;
+    delete[] dataptr;
+  }
+  MyVector(std::initializer_list< T > &l)
+  {
+    for (auto i : l) {
+      push_back(i);
+    }
+  }
+  void push_back(const T &i)
+  {
+    if (! len) {
+      maxlen  = 1;
+      dataptr = new T[ maxlen ];
+    } else if (len >= maxlen) {
+      maxlen *= 2;
+      auto newdata = new T[ maxlen ];
+      std::copy(dataptr, dataptr + len, newdata);
+      if (dataptr) {
+        delete[] dataptr;
+      }
+      dataptr = newdata;
+    }
+    dataptr[ len++ ] = i;
+    std::cout << "push_back called " << to_string() << std::endl;
+  }
+  friend std::ostream &operator<<(std::ostream &os, const MyVector< T > &o)
+  {
+    auto s = o.dataptr;
+    auto e = o.dataptr + o.len;
+    ;
+    while (s < e) {
+      os << "[" << *s << "]";
+      s++;
+    }
+    return os;
+  }
+  std::string to_string(void) const
+  {
+    auto              address = static_cast< const void              *>(this);
+    std::stringstream ss;
+    ss << address;
+
+    std::string elems;
+    auto        s = dataptr;
+    auto        e = dataptr + len;
+    ;
+    while (s < e) {
+      elems += *s;
+      s++;
+      if (s < e) {
+        elems += ",";
+      }
+    }
+
+    return "MyVector(" + ss.str() + ", len=" + std::to_string(len) + ", maxlen=" + std::to_string(maxlen) +
+           " elems=[" + elems + "])";
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Multikey quicksort (Bentley and Sedgewick) for ranges of std::string.
+//
+// A comparison sort compares whole strings, so every comparison of two
+// strings with a long common prefix reads that prefix again. Multikey
+// quicksort instead partitions on one "character" at a time:
+//
+// - pick a pivot character at position depth
+// - split the range three ways: less than, equal to, and greater than it
+// - sort the "less" and "greater" parts on the same character
+// - sort the "equal" part on the next character along
+//
+// so each character of a shared prefix is looked at about once per
+// partition step, not once per comparison.
+//
+// Each string's bytes live in their own heap block, and reading one is
+// usually a cache miss. So we do not sort the strings themselves. Instead
+// we sort an array of { key, pointer to string } entries, where the key is
+// the next 8 characters of the string packed into a uint64_t, so one
+// integer compare checks 8 characters. Only when moving on to the next 8
+// characters do we go back to the strings themselves. Once the entries
+// are in order, each string is moved into place exactly once.
+//
+// Descending sorts the other way round, for std::greater.
+////////////////////////////////////////////////////////////////////////////
+template < class Iter, bool Descending > class MultikeyQuicksort
+{
+private:
+  struct Entry {
+    uint64_t     key;
+    std::string *s;
+  };
+
+  static constexpr size_t         key_chars        = sizeof(uint64_t);
+  static constexpr std::ptrdiff_t insertion_cutoff = 32;
+
+  //
+  // key_chars characters of s from depth, first character in the top byte
+  // so that comparing keys compares characters in order. Past the end of
+  // the string we pad with zeros. std::string compares chars as unsigned,
+  // and so do we.
+  //
+  static uint64_t key_at(const std::string &s, size_t depth)
+  {
+    uint64_t k = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (depth + key_chars <= s.size()) {
+      std::memcpy(&k, s.data() + depth, key_chars);
+      k = __builtin_bswap64(k);
+      return Descending ? ~k : k;
+    }
+#endif
+    for (size_t i = 0; i < key_chars; i++) {
+      k <<= 8;
+      if (depth + i < s.size()) {
+        k |= (unsigned char) s[ depth + i ];
+      }
+    }
+    return Descending ? ~k : k;
+  }
+
+  //
+  // Everything in the range shares its first depth characters, so only
+  // look at what comes after
+  //
+  static bool before(const Entry &a, const Entry &b, size_t depth)
+  {
+    if (a.key != b.key) {
+      return a.key < b.key;
+    }
+    auto c = a.s->compare(depth, std::string::npos, *b.s, depth, std::string::npos);
+    return Descending ? c > 0 : c < 0;
+  }
+
+  static void insertion_sort(Entry *e, std::ptrdiff_t n, size_t depth)
+  {
+    for (std::ptrdiff_t i = 1; i < n; i++) {
+      auto x = e[ i ];
+      auto j = i;
+      for (; j > 0 && before(x, e[ j - 1 ], depth); j--) {
+        e[ j ] = e[ j - 1 ];
+      }
+      e[ j ] = x;
+    }
+  }
+
+  static uint64_t median_of_three(uint64_t a, uint64_t b, uint64_t c)
+  {
+    if (a < b) {
+      return b < c ? b : (a < c ? c : a);
+    }
+    return a < c ? a : (b < c ? c : b);
+  }
+
+  //
+  // A part of the range still to sort, all of whose keys are for the
+  // characters from depth on
+  //
+  struct Part {
+    Entry         *e;
+    std::ptrdiff_t n;
+    size_t         depth;
+  };
+
+  //
+  // How many partitions on the same characters we allow before deciding
+  // the pivots are bad and handing over to std::sort, as introsort does
+  //
+  static int depth_budget(std::ptrdiff_t n) { return 2 * (int) std::bit_width((size_t) n); }
+
+  //
+  // In the equal part, a string that ends within these characters is a
+  // prefix of any that go on, so it comes first (last if descending).
+  // Such strings can only differ by trailing '\0's, and there are rarely
+  // more than one of them. Sort those now, and return the rest, keyed on
+  // the next key_chars characters.
+  //
+  // If everything shared these characters, it may well share more; skip to
+  // the end of that common prefix in one pass rather than one pass per
+  // key_chars characters.
+  //
+  static Part next_key(Part p, bool all_equal)
+  {
+    auto ended = [ depth = p.depth ](const Entry &x) { return x.s->size() <= depth + key_chars; };
+    auto mid   = Descending ? std::partition(p.e, p.e + p.n, [ & ](const Entry &x) { return ! ended(x); })
+                            : std::partition(p.e, p.e + p.n, ended);
+    if (Descending) {
+      insertion_sort(mid, p.e + p.n - mid, p.depth);
+      p.n = mid - p.e;
+    } else {
+      insertion_sort(p.e, mid - p.e, p.depth);
+      p.n = p.e + p.n - mid;
+      p.e = mid;
+    }
+
+    p.depth += key_chars;
+    if (all_equal && p.n > 1) {
+      auto &first_s = *p.e[ 0 ].s;
+      auto  common  = first_s.size();
+      for (std::ptrdiff_t j = 1; j < p.n && common > p.depth; j++) {
+        auto &s = *p.e[ j ].s;
+        auto  k = p.depth;
+        auto  m = std::min(common, s.size());
+        while (k < m && first_s[ k ] == s[ k ]) {
+          k++;
+        }
+        common = k;
+      }
+      p.depth = common;
+    }
+    for (std::ptrdiff_t j = 0; j < p.n; j++) {
+      p.e[ j ].key = key_at(*p.e[ j ].s, p.depth);
+    }
+    return p;
+  }
+
+  static void sort(Entry *e, std::ptrdiff_t n, size_t depth, int budget)
+  {
+    while (n > insertion_cutoff) {
+      if (budget-- == 0) {
+        std::sort(e, e + n, [ depth ](const Entry &a, const Entry &b) { return before(a, b, depth); });
+        return;
+      }
+
+      auto pivot = median_of_three(e[ 0 ].key, e[ n / 2 ].key, e[ n - 1 ].key);
+
+      //
+      // Dutch national flag partition: [0, lt) less, [lt, i) equal,
+      // [gt, n) greater
+      //
+      std::ptrdiff_t lt = 0, i = 0, gt = n;
+      while (i < gt) {
+        if (e[ i ].key < pivot) {
+          std::swap(e[ lt++ ], e[ i++ ]);
+        } else if (e[ i ].key > pivot) {
+          std::swap(e[ i ], e[ --gt ]);
+        } else {
+          i++;
+        }
+      }
+
+      //
+      // Recurse into the two smaller parts, each at most half the range,
+      // and carry on with the largest without recursing, so the stack
+      // never grows past log2(n). The equal part moves on to the next
+      // characters, so starts a budget of its own.
+      //
+      Part less {e, lt, depth};
+      Part greater {e + gt, n - gt, depth};
+      Part equal = next_key(Part {e + lt, gt - lt, depth}, (lt == 0) && (gt == n));
+
+      std::pair< Part, int > parts[ 3 ] = {{less, budget}, {greater, budget}, {equal, depth_budget(equal.n)}};
+      std::sort(parts, parts + 3, [](const auto &a, const auto &b) { return a.first.n < b.first.n; });
+      sort(parts[ 0 ].first.e, parts[ 0 ].first.n, parts[ 0 ].first.depth, parts[ 0 ].second);
+      sort(parts[ 1 ].first.e, parts[ 1 ].first.n, parts[ 1 ].first.depth, parts[ 1 ].second);
+      e      = parts[ 2 ].first.e;
+      n      = parts[ 2 ].first.n;
+      depth  = parts[ 2 ].first.depth;
+      budget = parts[ 2 ].second;
+    }
+    insertion_sort(e, n, depth);
+  }
+
+public:
+  static void sort(Iter first, Iter last)
+  {
+    auto                 n = last - first;
+    std::vector< Entry > entries(n);
+    auto                 it = first;
+    for (auto &entry : entries) {
+      entry.s   = &*it;
+      entry.key = key_at(*entry.s, 0);
+      ++it;
+    }
+
+    sort(entries.data(), n, 0, depth_budget(n));
+
+    std::vector< std::string > sorted;
+    sorted.reserve(n);
+    for (const auto &entry : entries) {
+      sorted.push_back(std::move(*entry.s));
+    }
+    it = first;
+    for (auto &s : sorted) {
+      *it = std::move(s);
+      ++it;
+    }
+  }
+};
+
+//
+// Comparators known to mean plain lexicographic order, either way round
+//
+template < class Compare > struct is_string_less : std::false_type {};
+template <> struct is_string_less< std::less< std::string > > : std::true_type {};
+template <> struct is_string_less< std::less<> > : std::true_type {};
+template < class Compare > struct is_string_greater : std::false_type {};
+template <> struct is_string_greater< std::greater< std::string > > : std::true_type {};
+template <> struct is_string_greater< std::greater<> > : std::true_type {};
+
+//
+// Sort like std::sort, but pick multikey quicksort when sorting strings in
+// plain lexicographic order. A lambda could compare in any order at all,
+// so that always goes to std::sort.
+//
+template < class Iter, class Compare = std::less<> > void my_sort(Iter first, Iter last, Compare comp = Compare())
+{
+  using T = typename std::iterator_traits< Iter >::value_type;
+  if constexpr (std::is_same_v< T, std::string > && is_string_less< Compare >::value) {
+    MultikeyQuicksort< Iter, false >::sort(first, last);
+  } else if constexpr (std::is_same_v< T, std::string > && is_string_greater< Compare >::value) {
+    MultikeyQuicksort< Iter, true >::sort(first, last);
+  } else {
+    std::sort(first, last, comp);
+  }
+}
+
+//
+// Account identifiers: long, and all sharing most of their prefix
+//
+static std::vector< std::string > account_ids(size_t n)
+{
+  std::mt19937                            rng(42);
+  std::uniform_int_distribution< size_t > region(0, 9);
+  std::uniform_int_distribution< size_t > branch(0, 99);
+  std::vector< std::string >              ids(n);
+  for (size_t i = 0; i < n; i++) {
+    ids[ i ] = "galactic-bank/sector-zz9-plural-z-alpha/region-" + std::to_string(region(rng)) + "/branch-"
+             + std::to_string(branch(rng)) + "/account-" + std::to_string(rng());
+  }
+  return ids;
+}
+
+static std::vector< std::string > random_names(size_t n)
+{
+  std::mt19937                            rng(42);
+  std::uniform_int_distribution< int >    letter('a', 'z');
+  std::uniform_int_distribution< size_t > length(8, 24);
+  std::vector< std::string >              names(n);
+  for (auto &name : names) {
+    name.resize(length(rng));
+    for (auto &c : name) {
+      c = letter(rng);
+    }
+  }
+  return names;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Sort a fresh copy of the strings with sorter, and check the result
+//
+template < class Sorter >
+static void bench(const std::string &name, const std::vector< std::string > &strings,
+                  const std::vector< std::string > &expected, Sorter sorter)
+{
+  auto v     = strings;
+  auto start = std::chrono::steady_clock::now();
+  sorter(v);
+  auto ms = elapsed_ms(start);
+  std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << ms << " ms" << std::endl;
+  if (v != expected) {
+    FAILED(name << " did not sort correctly");
+  }
+}
+
+//
+// A copy of v with an empty string in front
+//
+static std::vector< std::string > with_spare(const std::vector< std::string > &v)
+{
+  std::vector< std::string > padded(v.size() + 1);
+  std::copy(v.begin(), v.end(), padded.begin() + 1);
+  return padded;
+}
+
+static void bench_all(const std::vector< std::string > &strings)
+{
+  auto lambda = [](const std::string &a, const std::string &b) { return a < b; };
+
+  auto expected = strings;
+  std::sort(expected.begin(), expected.end());
+  auto reversed = expected;
+  std::reverse(reversed.begin(), reversed.end());
+
+  //
+  // MyVector prints every element whenever it is copied or destroyed, so
+  // here MyIterator and MyReverseIterator walk a std::vector's storage
+  // instead
+  //
+  auto my_begin = [](std::vector< std::string > &v) { return MyIterator< std::string >(v.data()); };
+  auto my_end   = [](std::vector< std::string > &v) { return MyIterator< std::string >(v.data() + v.size()); };
+
+  //
+  // A MyReverseIterator at rend() points one before the first element. So
+  // the reverse runs sort all but a spare first string, and rend() is that
+  // string rather than a pointer outside the vector.
+  //
+  auto padded          = with_spare(strings);
+  auto padded_reversed = with_spare(reversed);
+  auto my_rbegin       = [](std::vector< std::string > &v) {
+    return MyReverseIterator< std::string >(v.data() + v.size() - 1);
+  };
+  auto my_rend = [](std::vector< std::string > &v) { return MyReverseIterator< std::string >(v.data()); };
+
+  bench("std::sort, lambda, MyIterator", strings, expected, [ & ](std::vector< std::string > &v) {
+    std::sort(my_begin(v), my_end(v), lambda);
+  });
+  bench("my_sort, std::less<>, MyIterator", strings, expected, [ & ](std::vector< std::string > &v) {
+    my_sort(my_begin(v), my_end(v), std::less<>());
+  });
+  bench("std::sort, lambda, MyReverseIterator", padded, padded_reversed, [ & ](std::vector< std::string > &v) {
+    std::sort(my_rbegin(v), my_rend(v), lambda);
+  });
+  bench("my_sort, std::less<>, MyReverseIterator", padded, padded_reversed, [ & ](std::vector< std::string > &v) {
+    my_sort(my_rbegin(v), my_rend(v), std::less<>());
+  });
+  bench("my_sort, std::greater<>, MyIterator", strings, reversed, [ & ](std::vector< std::string > &v) {
+    my_sort(my_begin(v), my_end(v), std::greater<>());
+  });
+}
+
+int main(int argc, char *argv[])
+{
+  DOC("Create a std::initializer_list of std::string:");
+  std::initializer_list< std::string > init1 = {"zaphod", "universe", "arthur", "marvin", "mice", "vogon"};
+
+  DOC("Assign this initializer_list to a vector:");
+  MyVector< std::string > vec1(init1);
+
+  my_sort(vec1.begin(), vec1.end());
+
+  DOC("Post sort, with multikey quicksort:");
+  for (const auto &i : vec1) {
+    std::cout << i << std::endl;
+  }
+
+  my_sort(vec1.rbegin(), vec1.rend(), std::less< std::string >());
+
+  DOC("Reverse sort, with multikey quicksort:");
+  for (const auto &i : vec1) {
+    std::cout << i << std::endl;
+  }
+
+  my_sort(vec1.begin(), vec1.end(), [](const std::string &a, const std::string &b) { return a.size() < b.size(); });
+
+  DOC("Sort by length, with std::sort:");
+  for (const auto &i : vec1) {
+    std::cout << i << std::endl;
+  }
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Sort " << n << " account ids with long common prefixes");
+  bench_all(account_ids(n));
+
+  DOC("Sort " << n << " random names");
+  bench_all(random_names(n));
+
+  DOC("End:");
+}
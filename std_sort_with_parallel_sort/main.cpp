@@ -0,0 +1,621 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <compare>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> // std::atol
+#ifdef WITH_STD_EXECUTION
+#include <execution>
+#endif
+#include <initializer_list>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+template < typename T > class MyIterator
+{
+public:
+  //
+  // iterator_concept tells C++20 algorithms the elements sit side by side
+  // in memory, so they may work on the memory directly (e.g. memmove).
+  // iterator_category is what older code looks at.
+  //
+  using iterator_concept  = std::contiguous_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
+  using difference_type   = std::ptrdiff_t;
+  using value_type        = std::remove_cv_t< T >;
+  using element_type      = T;
+  using pointer           = T *;
+  using reference         = T &;
+
+  MyIterator(T *ptr = nullptr) { dataptr = ptr; }
+  MyIterator(const MyIterator< T > &it) = default;
+  //
+  // An iterator can always become a const_iterator, but not the other way
+  //
+  template < typename U, typename = std::enable_if_t< std::is_convertible_v< U *, T * > > >
+  MyIterator(const MyIterator< U > &it) : dataptr(it.get_ptr())
+  {
+  }
+  MyIterator< T > base()
+  {
+    MyIterator< T > forwardIterator(this->dataptr);
+    ++forwardIterator;
+    return forwardIterator;
+  }
+  MyIterator< T > operator+(difference_type delta) const { return MyIterator< T >(dataptr + delta); }
+  friend MyIterator< T > operator+(difference_type delta, const MyIterator< T > &it) { return it + delta; }
+  MyIterator< T >        operator++(int)
+  {
+    auto temp(*this);
+    ++dataptr;
+    return temp;
+  }
+  MyIterator< T > operator-(difference_type delta) const { return MyIterator< T >(dataptr - delta); }
+  MyIterator< T > operator--(int)
+  {
+    auto temp(*this);
+    --dataptr;
+    return temp;
+  }
+  MyIterator< T > &operator++()
+  {
+    ++dataptr;
+    return (*this);
+  }
+  MyIterator< T > &operator+=(difference_type delta)
+  {
+    dataptr += delta;
+    return (*this);
+  }
+  MyIterator< T > &operator--()
+  {
+    --dataptr;
+    return (*this);
+  }
+  MyIterator< T > &operator-=(difference_type delta)
+  {
+    dataptr -= delta;
+    return (*this);
+  }
+  MyIterator< T > &operator=(T *ptr)
+  {
+    dataptr = ptr;
+    return (*this);
+  }
+  MyIterator< T > &operator=(const MyIterator< T > &it) = default;
+  //
+  // A const iterator is one that cannot be moved, not one whose elements
+  // cannot be changed; that is what MyIterator< const T > is for
+  //
+  T              &operator*() const { return *dataptr; }
+  T              &operator[](difference_type i) const { return dataptr[ i ]; }
+  T              *operator->() const { return dataptr; }
+  T              *get_ptr() const { return dataptr; }
+  const T        *get_const_ptr() const { return dataptr; }
+  difference_type operator-(const MyIterator< T > &it) const { return dataptr - it.dataptr; }
+  bool            operator==(const MyIterator< T > &it) const = default;
+  auto            operator<=>(const MyIterator< T > &it) const = default;
+  explicit        operator bool() const { return dataptr != nullptr; }
+  ~MyIterator() {}
+
+protected:
+  T *dataptr; // can be used by parent class, but not publically
+};
+
+template < typename T > class MyReverseIterator
+{
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using difference_type   = std::ptrdiff_t;
+  using value_type        = std::remove_cv_t< T >;
+  using pointer           = T *;
+  using reference         = T &;
+
+  MyReverseIterator(T *ptr = nullptr) { dataptr = ptr; }
+  MyReverseIterator(const MyReverseIterator< T > &it) = default;
+  template < typename U, typename = std::enable_if_t< std::is_convertible_v< U *, T * > > >
+  MyReverseIterator(const MyReverseIterator< U > &it) : dataptr(it.get_ptr())
+  {
+  }
+  MyReverseIterator< T > base()
+  {
+    MyReverseIterator< T > forwardIterator(this->dataptr);
+    ++forwardIterator;
+    return forwardIterator;
+  }
+  MyReverseIterator< T > operator+(difference_type delta) const { return MyReverseIterator< T >(dataptr - delta); }
+  friend MyReverseIterator< T > operator+(difference_type delta, const MyReverseIterator< T > &it)
+  {
+    return it + delta;
+  }
+  MyReverseIterator< T > operator++(int)
+  {
+    auto temp(*this);
+    --dataptr;
+    return temp;
+  }
+  MyReverseIterator< T > operator-(difference_type delta) const { return MyReverseIterator< T >(dataptr + delta); }
+  MyReverseIterator< T > operator--(int)
+  {
+    auto temp(*this);
+    ++dataptr;
+    return temp;
+  }
+  MyReverseIterator< T > &operator++()
+  {
+    --dataptr;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator+=(difference_type delta)
+  {
+    dataptr -= delta;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator--()
+  {
+    ++dataptr;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator-=(difference_type delta)
+  {
+    dataptr += delta;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator=(T *ptr)
+  {
+    dataptr = ptr;
+    return (*this);
+  }
+  MyReverseIterator< T > &operator=(const MyReverseIterator< T > &it) = default;
+  T                      &operator*() const { return *dataptr; }
+  T                      &operator[](difference_type i) const { return *(dataptr - i); }
+  T                      *operator->() const { return dataptr; }
+  T                      *get_ptr() const { return dataptr; }
+  const T                *get_const_ptr() const { return dataptr; }
+  //
+  // The pointers run backwards, so a later reverse iterator has the lower
+  // address
+  //
+  difference_type operator-(const MyReverseIterator< T > &it) const { return it.dataptr - dataptr; }
+  bool            operator==(const MyReverseIterator< T > &it) const = default;
+  auto            operator<=>(const MyReverseIterator< T > &it) const { return it.dataptr <=> dataptr; }
+  explicit        operator bool() const { return dataptr != nullptr; }
+  ~MyReverseIterator() {}
+
+protected:
+  T *dataptr; // can be used by parent class, but not publically
+};
+
+//
+// Checked at compile time, so the standard algorithms are sure to accept them
+//
+static_assert(std::contiguous_iterator< MyIterator< int > >);
+static_assert(std::contiguous_iterator< MyIterator< const int > >);
+static_assert(std::random_access_iterator< MyReverseIterator< int > >);
+static_assert(std::random_access_iterator< MyReverseIterator< const int > >);
+
+template < typename T > class MyVector
+{
+private:
+  T     *dataptr {};
+  size_t maxlen {};
+  size_t len {};
+
+public:
+  typedef MyIterator< T >              iterator;
+  typedef MyIterator< const T >        const_iterator;
+  typedef MyReverseIterator< T >       reverse_iterator;
+  typedef MyReverseIterator< const T > const_reverse_iterator;
+
+  iterator               begin() { return iterator(&dataptr[ 0 ]); }
+  iterator               end() { return iterator(&dataptr[ len ]); }
+  const_iterator         cbegin() { return const_iterator(&dataptr[ 0 ]); }
+  const_iterator         cend() { return const_iterator(&dataptr[ len ]); }
+  reverse_iterator       rbegin() { return reverse_iterator(&dataptr[ len - 1 ]); }
+  reverse_iterator       rend() { return reverse_iterator(&dataptr[ -1 ]); }
+  const_reverse_iterator crbegin() { return const_reverse_iterator(&dataptr[ len - 1 ]); }
+  const_reverse_iterator crend() { return const_reverse_iterator(&dataptr[ -1 ]); }
+
+  MyVector() : dataptr(nullptr), maxlen(0), len(0)
+  {
+    std::cout << "default constructor " << to_string() << std::endl;
+  }
+  MyVector(int maxlen) : dataptr(new T[ maxlen ]), maxlen(maxlen), len(0)
+  {
+    std::cout << "new " << to_string() << std::endl;
+  }
+  MyVector(const MyVector &o)
+  {
+    std::cout << "copy constructor called for " << o.to_string() << std::endl;
+    dataptr = new T[ o.maxlen ];
+    maxlen  = o.maxlen;
+    len     = o.len;
+    std::copy(o.dataptr, o.dataptr + o.maxlen, dataptr);
+    std::cout << "copy constructor result is  " << to_string() << std::endl;
+  }
+  MyVector(MyVector< T > &&o)
+  {
+    std::cout << "std::move called for " << o.to_string() << std::endl;
+    dataptr   = o.dataptr;
+    maxlen    = o.maxlen;
+    len       = o.len;
+    o.dataptr = nullptr;
+    o.maxlen  = 0;
+    o.len     = 0;
+    std::cout << "std::move result is  " << to_string() << std::endl;
+  }
+  ~MyVector()
+  {
+    std::cout << "delete " << to_string() << std::endl;
+    delete[] dataptr;
+  }
+  MyVector(std::initializer_list< T > &l)
+  {
+    for (auto i : l) {
+      push_back(i);
+    }
+  }
+  void push_back(const T &i)
+  {
+    if (! len) {
+      maxlen  = 1;
+      dataptr = new T[ maxlen ];
+    } else if (len >= maxlen) {
+      maxlen *= 2;
+      auto newdata = new T[ maxlen ];
+      std::copy(dataptr, dataptr + len, newdata);
+      if (dataptr) {
+        delete[] dataptr;
+      }
+      dataptr = newdata;
+    }
+    dataptr[ len++ ] = i;
+    std::cout << "push_back called " << to_string() << std::endl;
+  }
+  friend std::ostream &operator<<(std::ostream &os, const MyVector< T > &o)
+  {
+    auto s = o.dataptr;
+    auto e = o.dataptr + o.len;
+    ;
+    while (s < e) {
+      os << "[" << *s << "]";
+      s++;
+    }
+    return os;
+  }
+  std::string to_string(void) const
+  {
+    auto              address = static_cast< const void              *>(this);
+    std::stringstream ss;
+    ss << address;
+
+    std::string elems;
+    auto        s = dataptr;
+    auto        e = dataptr + len;
+    ;
+    while (s < e) {
+      elems += *s;
+      s++;
+      if (s < e) {
+        elems += ",";
+      }
+    }
+
+    return "MyVector(" + ss.str() + ", len=" + std::to_string(len) + ", maxlen=" + std::to_string(maxlen) +
+           " elems=[" + elems + "])";
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A parallel sample sort, for any random access iterator.
+//
+// 1. Take a sample of the input, sort it, and pick evenly spaced
+//    splitters from it. Between them the splitters cut the range into
+//    buckets of about the same size.
+//
+// 2. Each thread takes a slice of the input and works out which bucket
+//    each of its elements belongs in, and counts them.
+//
+// 3. From the counts, every thread knows where its share of each bucket
+//    goes, so all threads can move their elements into a buffer at once
+//    with no locking.
+//
+// 4. The threads take buckets in turn, move each one back to where it
+//    belongs in the original range, and std::sort it there. Once every
+//    bucket is sorted, so is the whole range.
+//
+// Elements equal to a splitter get a bucket of their own, which needs no
+// sorting, so lots of duplicates do not all end up in one huge bucket.
+////////////////////////////////////////////////////////////////////////////
+template < class Iter, class Compare > class SampleSort
+{
+private:
+  using T = typename std::iterator_traits< Iter >::value_type;
+
+  //
+  // Below this, threads cost more than they save
+  //
+  static constexpr size_t serial_cutoff = 1 << 14;
+  static constexpr size_t oversample    = 32;
+
+  Iter                    first;
+  size_t                  n;
+  Compare                 comp;
+  size_t                  nthreads;
+  std::vector< T >        splitters;
+  size_t                  nbuckets {};
+  std::vector< uint16_t > bucket_of;
+
+  //
+  // Run f(0) .. f(nthreads - 1), each on its own thread
+  //
+  template < class F > void on_each_thread(F f)
+  {
+    std::vector< std::thread > threads;
+    for (size_t t = 1; t < nthreads; t++) {
+      threads.emplace_back(f, t);
+    }
+    f(0);
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+
+  //
+  // Bucket 2i holds elements between splitters i - 1 and i. Bucket 2i - 1
+  // holds those equal to splitter i - 1.
+  //
+  size_t bucket(const T &x) const
+  {
+    auto i = std::upper_bound(splitters.begin(), splitters.end(), x, comp) - splitters.begin();
+    if (i && ! comp(splitters[ i - 1 ], x)) {
+      return 2 * i - 1;
+    }
+    return 2 * i;
+  }
+
+  void pick_splitters(void)
+  {
+    //
+    // More buckets than threads, so that a thread that finishes a small
+    // bucket can go on to another
+    //
+    size_t nsplitters = nthreads * 4 - 1;
+    size_t nsamples   = (nsplitters + 1) * oversample;
+    std::vector< T > sample;
+    sample.reserve(nsamples);
+    std::mt19937 rng(n);
+    std::uniform_int_distribution< size_t > pick(0, n - 1);
+    for (size_t i = 0; i < nsamples; i++) {
+      sample.push_back(first[ (std::ptrdiff_t) pick(rng) ]);
+    }
+    std::sort(sample.begin(), sample.end(), comp);
+    for (size_t i = 1; i <= nsplitters; i++) {
+      splitters.push_back(sample[ i * oversample ]);
+    }
+    nbuckets = 2 * splitters.size() + 1;
+  }
+
+  size_t slice_begin(size_t t) const { return n * t / nthreads; }
+
+public:
+  SampleSort(Iter first, Iter last, Compare comp, size_t nthreads)
+      : first(first), n(last - first), comp(comp), nthreads(std::max(nthreads, (size_t) 1))
+  {
+  }
+
+  void sort(void)
+  {
+    if ((nthreads == 1) || (n < serial_cutoff)) {
+      std::sort(first, first + (std::ptrdiff_t) n, comp);
+      return;
+    }
+
+    pick_splitters();
+    bucket_of.resize(n);
+
+    //
+    // count[ t ][ b ] is how many of thread t's elements go in bucket b
+    //
+    std::vector< std::vector< size_t > > count(nthreads, std::vector< size_t >(nbuckets));
+    on_each_thread([ & ](size_t t) {
+      auto it = first + (std::ptrdiff_t) slice_begin(t);
+      for (auto i = slice_begin(t); i < slice_begin(t + 1); i++, ++it) {
+        auto b         = bucket(*it);
+        bucket_of[ i ] = b;
+        count[ t ][ b ]++;
+      }
+    });
+
+    //
+    // Bucket b starts at bucket_start[ b ], and thread t's share of it at
+    // offset[ t ][ b ]
+    //
+    std::vector< size_t >                bucket_start(nbuckets + 1);
+    std::vector< std::vector< size_t > > offset(nthreads, std::vector< size_t >(nbuckets));
+    size_t                               pos = 0;
+    for (size_t b = 0; b < nbuckets; b++) {
+      bucket_start[ b ] = pos;
+      for (size_t t = 0; t < nthreads; t++) {
+        offset[ t ][ b ] = pos;
+        pos += count[ t ][ b ];
+      }
+    }
+    bucket_start[ nbuckets ] = n;
+
+    std::allocator< T > alloc;
+    T                  *buf = alloc.allocate(n);
+    on_each_thread([ & ](size_t t) {
+      auto it = first + (std::ptrdiff_t) slice_begin(t);
+      for (auto i = slice_begin(t); i < slice_begin(t + 1); i++, ++it) {
+        new (buf + offset[ t ][ bucket_of[ i ] ]++) T(std::move(*it));
+      }
+    });
+
+    std::atomic< size_t > next_bucket {};
+    on_each_thread([ & ](size_t) {
+      for (size_t b; (b = next_bucket++) < nbuckets;) {
+        auto from = bucket_start[ b ];
+        auto to   = bucket_start[ b + 1 ];
+        auto out  = first + (std::ptrdiff_t) from;
+        for (auto i = from; i < to; i++, ++out) {
+          *out = std::move(buf[ i ]);
+          buf[ i ].~T();
+        }
+        //
+        // Odd buckets are all equal to one splitter, so already sorted
+        //
+        if (! (b & 1)) {
+          std::sort(first + (std::ptrdiff_t) from, first + (std::ptrdiff_t) to, comp);
+        }
+      }
+    });
+    alloc.deallocate(buf, n);
+  }
+};
+
+template < class Iter, class Compare >
+void parallel_sort(Iter first, Iter last, Compare comp, size_t nthreads = std::thread::hardware_concurrency())
+{
+  SampleSort< Iter, Compare >(first, last, comp, nthreads).sort();
+}
+
+static std::vector< std::string > random_names(size_t n)
+{
+  std::mt19937                            rng(42);
+  std::uniform_int_distribution< int >    letter('a', 'z');
+  std::uniform_int_distribution< size_t > length(8, 24);
+  std::vector< std::string >              names(n);
+  for (auto &name : names) {
+    name.resize(length(rng));
+    for (auto &c : name) {
+      c = letter(rng);
+    }
+  }
+  return names;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Sort a fresh copy of the names with sorter, and check the result against
+// what std::sort gave us
+//
+template < class Sorter >
+static void bench(const std::string &name, const std::vector< std::string > &names,
+                  const std::vector< std::string > &expected, Sorter sorter)
+{
+  auto v     = names;
+  auto start = std::chrono::steady_clock::now();
+  sorter(v);
+  auto ms = elapsed_ms(start);
+  std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << ms << " ms" << std::endl;
+  if (v != expected) {
+    FAILED(name << " did not sort correctly");
+  }
+}
+
+//
+// A copy of v with an empty string in front
+//
+static std::vector< std::string > with_spare(const std::vector< std::string > &v)
+{
+  std::vector< std::string > padded(v.size() + 1);
+  std::copy(v.begin(), v.end(), padded.begin() + 1);
+  return padded;
+}
+
+int main(int argc, char *argv[])
+{
+  DOC("Create a std::initializer_list of std::string:");
+  std::initializer_list< std::string > init1 = {"zaphod", "universe", "arthur", "marvin", "mice", "vogon"};
+
+  DOC("Assign this initializer_list to a vector:");
+  MyVector< std::string > vec1(init1);
+
+  auto less = [](const std::string &a, const std::string &b) { return a < b; };
+
+  parallel_sort(vec1.begin(), vec1.end(), less);
+
+  DOC("Post parallel sort:");
+  for (const auto &i : vec1) {
+    std::cout << i << std::endl;
+  }
+
+  parallel_sort(vec1.rbegin(), vec1.rend(), less);
+
+  DOC("Reverse parallel sort:");
+  for (const auto &i : vec1) {
+    std::cout << i << std::endl;
+  }
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+  size_t nthreads = std::max(std::thread::hardware_concurrency(), 1U);
+  if (argc > 2) {
+    nthreads = std::atol(argv[ 2 ]);
+  }
+
+  DOC("Sort " << n << " random names on " << nthreads << " thread(s)");
+  auto names = random_names(n);
+
+  //
+  // MyVector prints every element whenever it is copied or destroyed, so
+  // here MyIterator and MyReverseIterator walk a std::vector's storage
+  // instead
+  //
+  auto expected = names;
+  std::sort(expected.begin(), expected.end(), less);
+  auto reversed = expected;
+  std::reverse(reversed.begin(), reversed.end());
+
+  auto my_begin = [](std::vector< std::string > &v) { return MyIterator< std::string >(v.data()); };
+  auto my_end   = [](std::vector< std::string > &v) { return MyIterator< std::string >(v.data() + v.size()); };
+
+  //
+  // A MyReverseIterator at rend() points one before the first element. So
+  // the reverse runs sort all but a spare first name, and rend() is that
+  // name rather than a pointer outside the vector.
+  //
+  auto padded          = with_spare(names);
+  auto padded_reversed = with_spare(reversed);
+  auto my_rbegin       = [](std::vector< std::string > &v) {
+    return MyReverseIterator< std::string >(v.data() + v.size() - 1);
+  };
+  auto my_rend = [](std::vector< std::string > &v) { return MyReverseIterator< std::string >(v.data()); };
+
+  bench("std::sort, MyIterator", names, expected, [ & ](std::vector< std::string > &v) {
+    std::sort(my_begin(v), my_end(v), less);
+  });
+  bench("parallel_sort, MyIterator", names, expected, [ & ](std::vector< std::string > &v) {
+    parallel_sort(my_begin(v), my_end(v), less, nthreads);
+  });
+  bench("std::sort, MyReverseIterator", padded, padded_reversed, [ & ](std::vector< std::string > &v) {
+    std::sort(my_rbegin(v), my_rend(v), less);
+  });
+  bench("parallel_sort, MyReverseIterator", padded, padded_reversed, [ & ](std::vector< std::string > &v) {
+    parallel_sort(my_rbegin(v), my_rend(v), less, nthreads);
+  });
+#ifdef WITH_STD_EXECUTION
+  bench("std::sort(std::execution::par), MyIterator", names, expected, [ & ](std::vector< std::string > &v) {
+    std::sort(std::execution::par, my_begin(v), my_end(v), less);
+  });
+#endif
+
+  DOC("End:");
+}
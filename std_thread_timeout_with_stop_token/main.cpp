@@ -0,0 +1,151 @@
+#include "../common/common.h"
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+//
+// Return a timestamp std::string to we can see how long things take
+//
+std::string timestamp(void)
+{
+  auto now      = std::chrono::system_clock::now();
+  auto seconds  = std::chrono::time_point_cast< std::chrono::seconds >(now);
+  auto mseconds = std::chrono::duration_cast< std::chrono::milliseconds >(now - seconds);
+  auto date     = std::chrono::system_clock::to_time_t(now);
+
+  struct tm local_time;
+  localtime_r(&date, &local_time);
+
+  char buffer[ 128 ];
+  buffer[ 0 ]      = '\0';
+  auto buffer_size = sizeof(buffer) - 1;
+  auto out         = strftime(buffer, buffer_size, "%H:%M:%S", &local_time);
+  out += snprintf(buffer + out, buffer_size - out, ".%03d ", (int) mseconds.count());
+
+  return std::string(buffer);
+}
+
+//
+// Sleep, but wake up early if a stop is requested. Returns false if we
+// were stopped.
+//
+template < class Rep, class Period >
+bool cancellable_sleep_for(std::stop_token stop, const std::chrono::duration< Rep, Period > &duration)
+{
+  std::mutex                     my_mutex;
+  std::condition_variable_any    my_condition_var;
+  std::unique_lock< std::mutex > my_lock(my_mutex);
+  my_condition_var.wait_for(my_lock, stop, duration, [] { return false; });
+  return ! stop.stop_requested();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// A function that might block, but checks in with its stop_token so that
+// it can give up when asked to.
+////////////////////////////////////////////////////////////////////////////
+int my_function_that_might_block(std::stop_token stop, int x)
+{
+  DOC("Function begins at :" << timestamp());
+  DOC("Function argument  :" << x);
+  if (! cancellable_sleep_for(stop, std::chrono::seconds(x))) {
+    DOC("Function cancelled :" << timestamp());
+    return 0;
+  }
+  DOC("Function ends at   :" << timestamp());
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// A CPU bound function; it polls stop_requested() as it goes.
+////////////////////////////////////////////////////////////////////////////
+long my_function_that_might_spin(std::stop_token stop, long iterations)
+{
+  DOC("Function begins at :" << timestamp());
+  long i;
+  for (i = 0; i < iterations; i++) {
+    if (! (i % 1000000) && stop.stop_requested()) {
+      DOC("Function cancelled :" << timestamp() << "after " << i << " iterations");
+      break;
+    }
+  }
+  return i;
+}
+
+template < typename ret, typename T, typename... Rest >
+using fn = std::function< ret(std::stop_token, T, Rest...) >;
+
+template < typename ret, typename T, typename... Rest >
+ret wrap_my_slow_function(std::chrono::milliseconds timeout, fn< ret, T, Rest... > f, T t, Rest... rest)
+{
+  std::promise< ret > result;
+  auto                future = result.get_future();
+
+  //
+  // std::jthread passes its own stop_token as the first argument if the
+  // callable accepts one. Unlike a detached std::thread, it always joins
+  // in its destructor, and it is declared after result and future so it
+  // is destroyed first. The thread therefore can never outlive the
+  // locals it refers to.
+  //
+  std::jthread my_thread([ & ](std::stop_token stop) {
+    try {
+      result.set_value(f(stop, t, rest...));
+    } catch (...) {
+      result.set_exception(std::current_exception());
+    }
+  });
+
+  if (future.wait_for(timeout) == std::future_status::timeout) {
+    DOC("Timed out at       :" << timestamp());
+    //
+    // Ask the function to stop. The jthread destructor would do this for
+    // us too, but being explicit makes the intent clear. Either way the
+    // destructor then joins, so when the exception leaves this function
+    // the work really has stopped.
+    //
+    my_thread.request_stop();
+    throw std::runtime_error("Timeout");
+  }
+
+  return future.get();
+}
+
+int main()
+{
+  DOC("Run a function that finishes in time");
+  try {
+    auto f1 = fn< int, int >(my_function_that_might_block);
+    wrap_my_slow_function(std::chrono::seconds(2), f1, 1);
+    SUCCESS("no timeout");
+  } catch (std::runtime_error &e) {
+    FAILED(e.what());
+  }
+
+  DOC("Run a function that might block; it should be cancelled promptly");
+  try {
+    auto f1 = fn< int, int >(my_function_that_might_block);
+    wrap_my_slow_function(std::chrono::seconds(1), f1, 10);
+    FAILED("expected a timeout");
+  } catch (std::runtime_error &e) {
+    SUCCESS("timed out, and the function has already stopped at " << timestamp());
+  }
+
+  DOC("Run a CPU bound function that polls its stop_token");
+  try {
+    auto f2 = fn< long, long >(my_function_that_might_spin);
+    wrap_my_slow_function(std::chrono::milliseconds(100), f2, 1000L * 1000L * 1000L * 1000L);
+    FAILED("expected a timeout");
+  } catch (std::runtime_error &e) {
+    SUCCESS("timed out, and the function has already stopped at " << timestamp());
+  }
+
+  DOC("End");
+
+  return 0;
+}
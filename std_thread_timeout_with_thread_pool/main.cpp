@@ -0,0 +1,226 @@
+#include "../common/common.h"
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Return a timestamp std::string to we can see how long things take
+//
+std::string timestamp(void)
+{
+  auto now      = std::chrono::system_clock::now();
+  auto seconds  = std::chrono::time_point_cast< std::chrono::seconds >(now);
+  auto mseconds = std::chrono::duration_cast< std::chrono::milliseconds >(now - seconds);
+  auto date     = std::chrono::system_clock::to_time_t(now);
+
+  struct tm local_time;
+  localtime_r(&date, &local_time);
+
+  char buffer[ 128 ];
+  buffer[ 0 ]      = '\0';
+  auto buffer_size = sizeof(buffer) - 1;
+  auto out         = strftime(buffer, buffer_size, "%H:%M:%S", &local_time);
+  out += snprintf(buffer + out, buffer_size - out, ".%03d ", (int) mseconds.count());
+
+  return std::string(buffer);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// A fixed number of worker threads, started once, that run jobs from a
+// shared queue. Submitting a job is a lock and a push; no thread is ever
+// created or destroyed per call.
+////////////////////////////////////////////////////////////////////////////
+class ThreadPool
+{
+public:
+  ThreadPool(size_t nthreads)
+  {
+    for (size_t i = 0; i < nthreads; i++) {
+      workers.emplace_back(&ThreadPool::run, this);
+    }
+  }
+  //
+  // Finish whatever is queued, then stop the workers
+  //
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard< std::mutex > my_lock(my_mutex);
+      stopping = true;
+    }
+    my_condition_var.notify_all();
+    for (auto &t : workers) {
+      t.join();
+    }
+  }
+  ThreadPool(const ThreadPool &)            = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function< void() > job)
+  {
+    {
+      std::lock_guard< std::mutex > my_lock(my_mutex);
+      jobs.push_back(std::move(job));
+    }
+    my_condition_var.notify_one();
+  }
+
+private:
+  void run()
+  {
+    for (;;) {
+      std::function< void() > job;
+      {
+        std::unique_lock< std::mutex > my_lock(my_mutex);
+        my_condition_var.wait(my_lock, [ this ] { return stopping || ! jobs.empty(); });
+        if (jobs.empty()) {
+          return;
+        }
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      job();
+    }
+  }
+
+  std::vector< std::thread >            workers;
+  std::deque< std::function< void() > > jobs;
+  std::mutex                            my_mutex;
+  std::condition_variable               my_condition_var;
+  bool                                  stopping {};
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A std::future that gives up waiting at a fixed point in time.
+////////////////////////////////////////////////////////////////////////////
+template < typename ret > class DeadlineFuture
+{
+public:
+  DeadlineFuture(std::future< ret > &&future, std::chrono::steady_clock::time_point deadline)
+      : future(std::move(future)), deadline(deadline)
+  {
+  }
+  //
+  // Return the result, or throw std::runtime_error("Timeout") if it is not
+  // ready by the deadline
+  //
+  ret get(void)
+  {
+    if (future.wait_until(deadline) == std::future_status::timeout) {
+      throw std::runtime_error("Timeout");
+    }
+    return future.get();
+  }
+
+private:
+  std::future< ret >                    future;
+  std::chrono::steady_clock::time_point deadline;
+};
+
+int my_function_that_might_block(int x)
+{
+  DOC("Function begins at :" << timestamp());
+  DOC("Function argument  :" << x);
+  std::this_thread::sleep_for(std::chrono::milliseconds(x));
+  DOC("Function ends at   :" << timestamp());
+  return x;
+}
+
+template < typename ret, typename T, typename... Rest > using fn = std::function< ret(T, Rest...) >;
+
+template < typename ret, typename T, typename... Rest >
+DeadlineFuture< ret > wrap_my_slow_function(ThreadPool &pool, std::chrono::steady_clock::duration timeout,
+                                            fn< ret, T, Rest... > f, T t, Rest... rest)
+{
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+
+  //
+  // The job owns everything it touches (the promise is shared with the
+  // future, the arguments are copies) so nothing dangles if the caller has
+  // given up and returned by the time it runs.
+  //
+  auto promise = std::make_shared< std::promise< ret > >();
+  auto future  = promise->get_future();
+
+  pool.submit([ promise, deadline, f, t, rest... ]() {
+    //
+    // If we sat in the queue past the deadline, nobody is waiting for the
+    // answer any more, so do not bother running at all.
+    //
+    if (std::chrono::steady_clock::now() >= deadline) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error("Timeout")));
+      return;
+    }
+    try {
+      promise->set_value(f(t, rest...));
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  });
+
+  return DeadlineFuture< ret >(std::move(future), deadline);
+}
+
+static int my_fast_function(int x) { return x + 1; }
+
+int main()
+{
+  ThreadPool pool(4);
+  auto       f1 = fn< int, int >(my_function_that_might_block);
+
+  DOC("Run a function that finishes before its deadline");
+  try {
+    auto result = wrap_my_slow_function(pool, std::chrono::seconds(1), f1, 100).get();
+    SUCCESS("result " << result);
+  } catch (std::runtime_error &e) {
+    FAILED(e.what());
+  }
+
+  DOC("Run a function that might block");
+  try {
+    wrap_my_slow_function(pool, std::chrono::seconds(1), f1, 2000).get();
+    FAILED("expected a timeout");
+  } catch (std::runtime_error &e) {
+    //
+    // Do whatever you need here upon timeout failure. Note the function is
+    // still running on one of the pool threads; it will finish in its own
+    // time, but it cannot leak a thread.
+    //
+    DOC("Timed out at       :" << timestamp());
+    SUCCESS("timed out as expected");
+  }
+
+  DOC("Make lots of quick calls, one new thread each vs the pool");
+  static const int calls = 20000;
+  auto             f2    = fn< int, int >(my_fast_function);
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) {
+      int         result;
+      std::thread t([ & ]() { result = f2(i); });
+      t.join();
+    }
+    auto secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    std::cout << "thread per call : " << (int) (calls / secs) << " calls/sec" << std::endl;
+  }
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) {
+      wrap_my_slow_function(pool, std::chrono::seconds(1), f2, i).get();
+    }
+    auto secs = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    std::cout << "thread pool     : " << (int) (calls / secs) << " calls/sec" << std::endl;
+  }
+
+  DOC("End, waiting for the pool to finish any work still running");
+
+  return 0;
+}
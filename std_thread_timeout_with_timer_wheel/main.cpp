@@ -0,0 +1,453 @@
+#include "../common/common.h"
+#include <algorithm> // std::max
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//
+// Return a timestamp std::string to we can see how long things take
+//
+std::string timestamp(void)
+{
+  auto now      = std::chrono::system_clock::now();
+  auto seconds  = std::chrono::time_point_cast< std::chrono::seconds >(now);
+  auto mseconds = std::chrono::duration_cast< std::chrono::milliseconds >(now - seconds);
+  auto date     = std::chrono::system_clock::to_time_t(now);
+
+  struct tm local_time;
+  localtime_r(&date, &local_time);
+
+  char buffer[ 128 ];
+  buffer[ 0 ]      = '\0';
+  auto buffer_size = sizeof(buffer) - 1;
+  auto out         = strftime(buffer, buffer_size, "%H:%M:%S", &local_time);
+  out += snprintf(buffer + out, buffer_size - out, ".%03d ", (int) mseconds.count());
+
+  return std::string(buffer);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// The fixed size worker pool from std_thread_timeout_with_thread_pool.
+////////////////////////////////////////////////////////////////////////////
+class ThreadPool
+{
+public:
+  ThreadPool(size_t nthreads)
+  {
+    for (size_t i = 0; i < nthreads; i++) {
+      workers.emplace_back(&ThreadPool::run, this);
+    }
+  }
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard< std::mutex > my_lock(my_mutex);
+      stopping = true;
+    }
+    my_condition_var.notify_all();
+    for (auto &t : workers) {
+      t.join();
+    }
+  }
+  ThreadPool(const ThreadPool &)            = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function< void() > job)
+  {
+    {
+      std::lock_guard< std::mutex > my_lock(my_mutex);
+      jobs.push_back(std::move(job));
+    }
+    my_condition_var.notify_one();
+  }
+
+private:
+  void run()
+  {
+    for (;;) {
+      std::function< void() > job;
+      {
+        std::unique_lock< std::mutex > my_lock(my_mutex);
+        my_condition_var.wait(my_lock, [ this ] { return stopping || ! jobs.empty(); });
+        if (jobs.empty()) {
+          return;
+        }
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      job();
+    }
+  }
+
+  std::vector< std::thread >            workers;
+  std::deque< std::function< void() > > jobs;
+  std::mutex                            my_mutex;
+  std::condition_variable               my_condition_var;
+  bool                                  stopping {};
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A hierarchical timer wheel. One thread tracks any number of deadlines.
+//
+// Time is counted in ticks. Level 0 has a slot for each of the next 256
+// ticks; level 1 has a slot for each of the next 256 blocks of 256 ticks,
+// and so on. A timer goes into the lowest level whose range covers it, so
+// adding one is O(1). Each tick we fire everything in the current level 0
+// slot. Every 256 ticks the next level 1 slot is emptied back down into
+// level 0 (and so on up the levels), so each timer is moved at most once
+// per level during its lifetime.
+//
+// Each slot is a std::list, so a timer can move between slots (splice) and
+// be cancelled (erase) without any other timer moving. schedule() returns
+// an id, and an index from id to list node makes cancel() O(1) too. A
+// cancelled timer, and whatever its callback holds on to, is freed there
+// and then rather than at its deadline.
+////////////////////////////////////////////////////////////////////////////
+class TimerWheel
+{
+public:
+  using Clock    = std::chrono::steady_clock;
+  using Callback = std::function< void() >;
+  using TimerId  = uint64_t;
+
+  TimerWheel(Clock::duration tick = std::chrono::milliseconds(1)) : tick(tick), start(Clock::now())
+  {
+    timer_thread = std::thread(&TimerWheel::run, this);
+  }
+  //
+  // Timers that have not fired yet are dropped
+  //
+  ~TimerWheel()
+  {
+    {
+      std::lock_guard< std::mutex > my_lock(my_mutex);
+      stopping = true;
+    }
+    my_condition_var.notify_all();
+    timer_thread.join();
+  }
+  TimerWheel(const TimerWheel &)            = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+
+  //
+  // Call fn on the timer thread at (or just after) deadline. fn should be
+  // quick; it holds up every other timer while it runs.
+  //
+  TimerId schedule(Clock::time_point deadline, Callback fn)
+  {
+    //
+    // Round up, so we never fire early
+    //
+    auto when = (uint64_t) ((std::max(deadline, start) - start + tick - Clock::duration(1)) / tick);
+    Slot node;
+    node.push_back(Timer {when, 0, std::move(fn), nullptr});
+    std::lock_guard< std::mutex > my_lock(my_mutex);
+    auto                          id = ++last_id;
+    node.front().id                  = id;
+    timers[ id ]                     = node.begin();
+    insert(node, node.begin());
+    return id;
+  }
+
+  //
+  // Drop a timer that has not fired yet. Returns false if it has already
+  // fired (or is firing right now), or was cancelled before.
+  //
+  bool cancel(TimerId id)
+  {
+    Slot dropped;
+    {
+      std::lock_guard< std::mutex > my_lock(my_mutex);
+      auto                          it = timers.find(id);
+      if (it == timers.end()) {
+        return false;
+      }
+      dropped.splice(dropped.end(), *it->second->slot, it->second);
+      timers.erase(it);
+    }
+    //
+    // The callback, and anything it holds, is destroyed here, outside the
+    // lock
+    //
+    return true;
+  }
+
+  //
+  // How many timers have neither fired nor been cancelled
+  //
+  size_t pending(void)
+  {
+    std::lock_guard< std::mutex > my_lock(my_mutex);
+    return timers.size();
+  }
+
+private:
+  static const int      slot_bits = 8;
+  static const uint64_t nslots    = 1 << slot_bits;
+  static const int      nlevels   = 4;
+
+  struct Timer;
+  using Slot = std::list< Timer >;
+
+  struct Timer {
+    uint64_t when;
+    TimerId  id;
+    Callback fn;
+    Slot    *slot; // the slot it is in, so cancel() can find it
+  };
+
+  //
+  // Move the timer at it, out of from, into the slot for its deadline
+  //
+  void insert(Slot &from, Slot::iterator it)
+  {
+    auto &t = *it;
+    //
+    // Anything already due goes in the very next tick
+    //
+    if (t.when <= now) {
+      t.when = now + 1;
+    }
+    auto delta = t.when - now;
+    int  level = 0;
+    while ((level < nlevels - 1) && (delta >= (uint64_t) 1 << (slot_bits * (level + 1)))) {
+      level++;
+    }
+    //
+    // Past the range of the top level; park it in the furthest slot, it will
+    // be re-inserted when that slot cascades
+    //
+    auto  when = std::min(t.when, now + ((uint64_t) 1 << (slot_bits * nlevels)) - 1);
+    auto &slot = wheel[ level ][ (when >> (slot_bits * level)) & (nslots - 1) ];
+    t.slot     = &slot;
+    slot.splice(slot.end(), from, it);
+  }
+
+  //
+  // Advance one tick, returning the timers that are now due
+  //
+  Slot advance(void)
+  {
+    now++;
+    for (int level = 1; level < nlevels; level++) {
+      if ((now >> (slot_bits * (level - 1))) & (nslots - 1)) {
+        break;
+      }
+      Slot cascade;
+      cascade.swap(wheel[ level ][ (now >> (slot_bits * level)) & (nslots - 1) ]);
+      while (! cascade.empty()) {
+        insert(cascade, cascade.begin());
+      }
+    }
+    //
+    // Once out of the index, a due timer can no longer be cancelled
+    //
+    Slot due;
+    due.swap(wheel[ 0 ][ now & (nslots - 1) ]);
+    for (auto &t : due) {
+      timers.erase(t.id);
+    }
+    return due;
+  }
+
+  void run()
+  {
+    std::unique_lock< std::mutex > my_lock(my_mutex);
+    while (! stopping) {
+      my_condition_var.wait_until(my_lock, start + (now + 1) * tick, [ this ] { return stopping; });
+      //
+      // Catch up on every tick that has passed, in case we were held up
+      //
+      while (! stopping && (Clock::now() >= start + (now + 1) * tick)) {
+        auto due = advance();
+        my_lock.unlock();
+        for (auto &t : due) {
+          t.fn();
+        }
+        due.clear();
+        my_lock.lock();
+      }
+    }
+  }
+
+  Clock::duration                                   tick;
+  Clock::time_point                                 start;
+  uint64_t                                          now {};
+  std::array< std::array< Slot, nslots >, nlevels > wheel;
+  std::unordered_map< TimerId, Slot::iterator >     timers;
+  TimerId                                           last_id {};
+  std::mutex                                        my_mutex;
+  std::condition_variable                           my_condition_var;
+  bool                                              stopping {};
+  std::thread                                       timer_thread;
+};
+
+int my_function_that_might_block(int x)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(x));
+  return x;
+}
+
+template < typename ret, typename T, typename... Rest > using fn = std::function< ret(T, Rest...) >;
+
+//
+// Shared between the job and its deadline; whichever gets there first
+// settles the promise.
+//
+template < typename ret > struct Call {
+  std::promise< ret > promise;
+  std::atomic< bool > settled {};
+};
+
+template < typename ret, typename T, typename... Rest >
+std::future< ret > wrap_my_slow_function(ThreadPool &pool, TimerWheel &timers, std::chrono::milliseconds timeout,
+                                         fn< ret, T, Rest... > f, T t, Rest... rest)
+{
+  auto call   = std::make_shared< Call< ret > >();
+  auto future = call->promise.get_future();
+
+  //
+  // No thread waits for this deadline; the timer wheel will fail the
+  // promise if the job has not settled it by then.
+  //
+  auto timer = timers.schedule(TimerWheel::Clock::now() + timeout, [ call ]() {
+    if (! call->settled.exchange(true)) {
+      call->promise.set_exception(std::make_exception_ptr(std::runtime_error("Timeout")));
+    }
+  });
+
+  //
+  // A job that settles in time cancels its deadline first, so the wheel
+  // lets go of the Call straight away, not when the deadline comes round
+  //
+  pool.submit([ call, timer, &timers, f, t, rest... ]() {
+    //
+    // Timed out while still queued; do not bother
+    //
+    if (call->settled) {
+      return;
+    }
+    try {
+      auto result = f(t, rest...);
+      if (! call->settled.exchange(true)) {
+        timers.cancel(timer);
+        call->promise.set_value(result);
+      }
+    } catch (...) {
+      if (! call->settled.exchange(true)) {
+        timers.cancel(timer);
+        call->promise.set_exception(std::current_exception());
+      }
+    }
+  });
+
+  return future;
+}
+
+int main()
+{
+  //
+  // Jobs cancel their timers, so the pool must go (and finish its jobs)
+  // before the timer wheel does
+  //
+  TimerWheel timers;
+  ThreadPool pool(4);
+  auto       f1 = fn< int, int >(my_function_that_might_block);
+
+  DOC("Run a function that finishes before its deadline");
+  try {
+    auto result = wrap_my_slow_function(pool, timers, std::chrono::seconds(1), f1, 100).get();
+    SUCCESS("result " << result);
+  } catch (std::runtime_error &e) {
+    FAILED(e.what());
+  }
+
+  DOC("Run a function that might block");
+  std::cout << "Started at         :" << timestamp() << std::endl;
+  try {
+    wrap_my_slow_function(pool, timers, std::chrono::seconds(1), f1, 2000).get();
+    FAILED("expected a timeout");
+  } catch (std::runtime_error &e) {
+    std::cout << "Timed out at       :" << timestamp() << std::endl;
+    SUCCESS("timed out as expected");
+  }
+
+  DOC("Track 100000 deadlines, spread over a second, on the one timer thread");
+  {
+    static const int    ntimers = 100000;
+    std::atomic< int >  fired {};
+    std::atomic< int >  early {};
+    std::atomic< long > max_late_us {};
+    unsigned            seed = 1;
+    auto                now  = TimerWheel::Clock::now();
+    for (int i = 0; i < ntimers; i++) {
+      seed          = seed * 1103515245 + 12345;
+      auto deadline = now + std::chrono::milliseconds(1 + (seed >> 16) % 1000);
+      timers.schedule(deadline, [ deadline, &fired, &early, &max_late_us ]() {
+        long late = std::chrono::duration_cast< std::chrono::microseconds >(TimerWheel::Clock::now() - deadline)
+                        .count();
+        if (late < 0) {
+          early++;
+        }
+        long prev = max_late_us;
+        while ((late > prev) && ! max_late_us.compare_exchange_weak(prev, late)) {
+        }
+        fired++;
+      });
+    }
+    while (fired < ntimers) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::cout << "fired " << fired << " timers, latest by " << max_late_us / 1000 << "ms" << std::endl;
+    if (! early) {
+      SUCCESS("no timer fired early");
+    } else {
+      FAILED(early << " timers fired early");
+    }
+  }
+
+  DOC("Make 20000 calls that each take 1ms, with a 100ms deadline, on 4 threads");
+  {
+    static const int                  ncalls = 20000;
+    std::vector< std::future< int > > futures;
+    auto                              start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ncalls; i++) {
+      futures.push_back(wrap_my_slow_function(pool, timers, std::chrono::milliseconds(100), f1, 1));
+    }
+    int ok = 0, timed_out = 0;
+    for (auto &f : futures) {
+      try {
+        f.get();
+        ok++;
+      } catch (std::runtime_error &e) {
+        timed_out++;
+      }
+    }
+    auto ms = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
+    std::cout << "completed " << ok << ", timed out " << timed_out << ", in " << ms.count() << "ms" << std::endl;
+    if (ok + timed_out == ncalls) {
+      SUCCESS("every call either completed or timed out");
+    }
+    if (! timers.pending()) {
+      SUCCESS("no timers left behind by calls that completed");
+    } else {
+      FAILED(timers.pending() << " timers left behind");
+    }
+  }
+
+  DOC("End, waiting for the pool to finish any work still running");
+
+  return 0;
+}
@@ -0,0 +1,402 @@
+//
+// Send DOC, SUCCESS and FAILED through the logger below rather than
+// straight to std::cout
+//
+#define COMMON_OUT log_stream()
+#include "../common/common.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib> // std::atoi
+#include <fstream>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>  // open
+#include <unistd.h> // write, close
+
+static const auto thread_loop_count = 1000;
+
+////////////////////////////////////////////////////////////////////////////
+// A logger that never makes the caller wait on I/O.
+//
+// Each record is pushed onto a lock-free multi-producer, single-consumer
+// queue (Vyukov's intrusive MPSC queue): a producer does one atomic
+// exchange and one store, and never waits for another producer. A single
+// writer thread drains whatever has built up and writes it out with one
+// write() call, so a burst of records from many threads costs one system
+// call rather than one each.
+////////////////////////////////////////////////////////////////////////////
+class Logger
+{
+public:
+  Logger(int fd) : fd(fd) { writer = std::thread(&Logger::run, this); }
+  //
+  // Write out everything posted so far, then stop the writer
+  //
+  ~Logger()
+  {
+    flush();
+    {
+      std::lock_guard< std::mutex > my_lock(my_mutex);
+      stopping = true;
+    }
+    my_condition_var.notify_all();
+    writer.join();
+    if (tail != &stub) {
+      delete tail;
+    }
+  }
+  Logger(const Logger &)            = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  //
+  // Queue one record. Safe to call from any thread.
+  //
+  void post(std::string &&text)
+  {
+    auto node  = new Node;
+    node->text = std::move(text);
+    posted++;
+    push(node);
+  }
+
+  //
+  // Wait until everything posted before this call has been written
+  //
+  void flush(void)
+  {
+    auto                           target = posted.load();
+    std::unique_lock< std::mutex > my_lock(my_mutex);
+    flushed_condition_var.wait(my_lock, [ & ] { return written >= target; });
+  }
+
+  size_t write_calls(void) const { return writes; }
+
+private:
+  struct Node {
+    std::atomic< Node * > next {};
+    std::string           text;
+  };
+
+  //
+  // Any thread
+  //
+  void push(Node *node)
+  {
+    auto prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node);
+    //
+    // Only touch the mutex if the writer has gone to sleep. Both this load
+    // and the store above are seq_cst, as are the writer's store to
+    // writer_sleeping and its check of the queue, so either we see it is
+    // asleep or it sees our record.
+    //
+    if (writer_sleeping.load()) {
+      { std::lock_guard< std::mutex > my_lock(my_mutex); }
+      my_condition_var.notify_one();
+    }
+  }
+
+  //
+  // Writer thread only
+  //
+  bool pop(std::string &text)
+  {
+    auto next = tail->next.load(std::memory_order_acquire);
+    if (! next) {
+      return false;
+    }
+    text = std::move(next->text);
+    if (tail != &stub) {
+      delete tail;
+    }
+    tail = next;
+    return true;
+  }
+
+  bool empty(void) const { return ! tail->next.load(); }
+
+  void write_all(const std::string &batch)
+  {
+    size_t done = 0;
+    while (done < batch.size()) {
+      auto n = ::write(fd, batch.data() + done, batch.size() - done);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      done += n;
+    }
+    writes++;
+  }
+
+  void run(void)
+  {
+    static const size_t max_batch = 64 * 1024;
+    std::string         batch;
+    std::string         text;
+
+    for (;;) {
+      size_t count = 0;
+      while ((batch.size() < max_batch) && pop(text)) {
+        batch += text;
+        count++;
+      }
+      if (count) {
+        write_all(batch);
+        batch.clear();
+        {
+          std::lock_guard< std::mutex > my_lock(my_mutex);
+          written += count;
+        }
+        flushed_condition_var.notify_all();
+        continue;
+      }
+
+      std::unique_lock< std::mutex > my_lock(my_mutex);
+      writer_sleeping = true;
+      my_condition_var.wait(my_lock, [ this ] { return stopping || ! empty(); });
+      writer_sleeping = false;
+      if (stopping && empty()) {
+        return;
+      }
+    }
+  }
+
+  int                     fd;
+  Node                    stub;
+  std::atomic< Node * >   head {&stub};
+  Node                   *tail {&stub};
+  std::atomic< size_t >   posted {};
+  size_t                  written {};
+  std::atomic< size_t >   writes {};
+  std::atomic< bool >     writer_sleeping {};
+  bool                    stopping {};
+  std::mutex              my_mutex;
+  std::condition_variable my_condition_var;
+  std::condition_variable flushed_condition_var;
+  std::thread             writer;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A std::streambuf that collects output in a private buffer and hands it
+// to a Logger as one record when flushed (e.g. by std::endl). Writing to
+// it takes no locks at all. Give each thread its own.
+////////////////////////////////////////////////////////////////////////////
+class LogBuf : public std::streambuf
+{
+public:
+  LogBuf(Logger &logger) : logger(logger) {}
+  ~LogBuf() { sync(); }
+
+protected:
+  int_type overflow(int_type c) override
+  {
+    if (! traits_type::eq_int_type(c, traits_type::eof())) {
+      buffer += traits_type::to_char_type(c);
+      post_if_full();
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *s, std::streamsize n) override
+  {
+    buffer.append(s, n);
+    post_if_full();
+    return n;
+  }
+
+  int sync() override
+  {
+    if (! buffer.empty()) {
+      logger.post(std::move(buffer));
+      buffer.clear();
+    }
+    return 0;
+  }
+
+private:
+  //
+  // Do not let a thread that never flushes hold on to unbounded output.
+  // Post up to the last complete line, so lines are still never split.
+  //
+  void post_if_full(void)
+  {
+    static const size_t max_buffered = 4096;
+    if (buffer.size() < max_buffered) {
+      return;
+    }
+    auto nl = buffer.rfind('\n');
+    if (nl != std::string::npos) {
+      logger.post(buffer.substr(0, nl + 1));
+      buffer.erase(0, nl + 1);
+    }
+  }
+
+  Logger     &logger;
+  std::string buffer;
+};
+
+class LogStream : public std::ostream
+{
+public:
+  LogStream(Logger &logger) : std::ostream(&buf), buf(logger) {}
+
+private:
+  LogBuf buf;
+};
+
+//
+// The logger for stdout, and this thread's stream into it
+//
+static Logger &logger(void)
+{
+  static Logger l(STDOUT_FILENO);
+  return l;
+}
+
+static std::ostream &log_stream(void)
+{
+  thread_local LogStream s(logger());
+  return s;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// The std_thread class wrapper, logging a line at a time. Each thread's
+// line is one record, so A's and B's no longer come out interleaved.
+////////////////////////////////////////////////////////////////////////////
+class MyThread
+{
+public:
+  ~MyThread()
+  {
+    log_stream() << to_string() << " destructor" << std::endl;
+    //
+    // Wait for our thread to finish
+    //
+    if (my_thread.joinable()) {
+      my_thread.join();
+    }
+  }
+  MyThread(const std::string &data, const int count) : data(data), count(count)
+  {
+    //
+    // Start our thread.
+    //
+    my_thread = std::thread(&MyThread::run, this);
+    log_stream() << to_string() << " constructor" << std::endl;
+  }
+  std::string to_string(void) const
+  {
+    std::stringstream ss;
+    ss << std::this_thread::get_id();
+    return "MyThread(" + ss.str() + ")";
+  }
+  void run()
+  {
+    auto &out = log_stream();
+    while (count--) {
+      out << data;
+    }
+    out << std::endl;
+  }
+
+private:
+  std::thread my_thread;
+  std::string data;
+  int         count;
+};
+
+static void thread_with_class_example()
+{
+  DOC("Start 2 threads with class wrappers");
+  MyThread thread1("A", thread_loop_count);
+  MyThread thread2("B", thread_loop_count);
+  DOC("Wait for threads to finish");
+}
+
+static double elapsed_secs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const std::string &name, size_t records, double secs, size_t write_calls)
+{
+  log_stream() << std::left << std::setw(32) << name << std::right << std::setw(12) << (size_t) (records / secs)
+               << " records/sec " << std::setw(8) << write_calls << " write calls" << std::endl;
+}
+
+//
+// Each of nthreads threads logs nrecords lines, flushing after every one,
+// to /dev/null
+//
+static void logging_benchmark(int nthreads, int nrecords)
+{
+  DOC("Log " << nrecords << " lines from each of " << nthreads << " threads to /dev/null");
+  {
+    std::ofstream devnull("/dev/null");
+    std::mutex    my_mutex;
+    auto          start = std::chrono::steady_clock::now();
+
+    std::vector< std::thread > threads;
+    for (int t = 0; t < nthreads; t++) {
+      threads.emplace_back([ &, t ] {
+        for (int i = 0; i < nrecords; i++) {
+          std::lock_guard< std::mutex > my_lock(my_mutex);
+          devnull << "thread " << t << " line " << i << std::endl;
+        }
+      });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+    report("shared stream behind a mutex", (size_t) nthreads * nrecords, elapsed_secs(start),
+           (size_t) nthreads * nrecords);
+  }
+  {
+    auto   fd = open("/dev/null", O_WRONLY);
+    Logger devnull(fd);
+    auto   start = std::chrono::steady_clock::now();
+
+    std::vector< std::thread > threads;
+    for (int t = 0; t < nthreads; t++) {
+      threads.emplace_back([ &, t ] {
+        LogStream out(devnull);
+        for (int i = 0; i < nrecords; i++) {
+          out << "thread " << t << " line " << i << std::endl;
+        }
+      });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+    devnull.flush();
+    report("per thread buffer, MPSC queue", (size_t) nthreads * nrecords, elapsed_secs(start), devnull.write_calls());
+    close(fd);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int nthreads = 4;
+  if (argc > 1) {
+    nthreads = std::atoi(argv[ 1 ]);
+  }
+
+  thread_with_class_example();
+  logging_benchmark(nthreads, 100000);
+
+  DOC("End");
+  return 0;
+}
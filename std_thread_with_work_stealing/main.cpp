@@ -0,0 +1,455 @@
+#include "../common/common.h"
+#include <algorithm> // std::max
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib> // std::atol
+#include <deque>
+#include <functional>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// A Chase-Lev work stealing deque.
+//
+// The owning thread pushes and takes at the bottom, like a stack, with no
+// locks and (usually) no atomic read-modify-write at all. Any other thread
+// may steal from the top, racing on a compare-and-swap of the top index.
+// Only when the owner and a thief go for the very last element do they
+// have to fight over it.
+//
+// See "Correct and Efficient Work-Stealing for Weak Memory Models",
+// Le, Pop, Cohen and Zappa Nardelli, PPoPP 2013.
+////////////////////////////////////////////////////////////////////////////
+template < class T > class WorkStealingDeque
+{
+public:
+  WorkStealingDeque(size_t capacity = 1024) : array(new Array(capacity)) {}
+  ~WorkStealingDeque()
+  {
+    delete array.load();
+    for (auto a : retired) {
+      delete a;
+    }
+  }
+  WorkStealingDeque(const WorkStealingDeque &)            = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  //
+  // Owner only
+  //
+  void push(T x)
+  {
+    auto b = bottom.load(std::memory_order_relaxed);
+    auto t = top.load(std::memory_order_acquire);
+    auto a = array.load(std::memory_order_relaxed);
+    if (b - t > (int64_t) a->mask) {
+      //
+      // Full; copy into an array twice the size. Thieves may still be
+      // reading the old one, so keep it around until we are destroyed.
+      //
+      retired.push_back(a);
+      a = a->grow(b, t);
+      array.store(a, std::memory_order_release);
+    }
+    a->put(b, x);
+    bottom.store(b + 1, std::memory_order_release);
+  }
+
+  //
+  // Owner only. Newest first.
+  //
+  bool take(T &x)
+  {
+    auto b = bottom.load(std::memory_order_relaxed) - 1;
+    auto a = array.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      //
+      // Empty
+      //
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    x = a->get(b);
+    if (t == b) {
+      //
+      // Last element; a thief may be after it too
+      //
+      auto won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  //
+  // Any thread. Oldest first. Returns false if empty, or if we lost a race
+  // with another thread for the element.
+  //
+  bool steal(T &x)
+  {
+    auto t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    auto a = array.load(std::memory_order_acquire);
+    x      = a->get(t);
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+private:
+  struct Array {
+    size_t                                mask;
+    std::unique_ptr< std::atomic< T >[] > buf;
+
+    Array(size_t capacity) : mask(capacity - 1), buf(new std::atomic< T >[ capacity ]) {}
+    T      get(int64_t i) const { return buf[ i & mask ].load(std::memory_order_relaxed); }
+    void   put(int64_t i, T x) { buf[ i & mask ].store(x, std::memory_order_relaxed); }
+    Array *grow(int64_t b, int64_t t) const
+    {
+      auto a = new Array((mask + 1) * 2);
+      for (auto i = t; i < b; i++) {
+        a->put(i, get(i));
+      }
+      return a;
+    }
+  };
+
+  alignas(64) std::atomic< int64_t > top {0};
+  alignas(64) std::atomic< int64_t > bottom {0};
+  std::atomic< Array * >             array;
+  std::vector< Array * >             retired;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A pool of worker threads, each with its own WorkStealingDeque.
+//
+// Tasks submitted by a worker go on that worker's own deque, which it
+// works through newest first (good for the cache, as the newest task is
+// most likely to touch data we just touched). Idle workers steal the
+// oldest task from a random victim; in a divide and conquer job that is
+// usually the biggest remaining piece of work, so a steal is rarely
+// wasted. Tasks submitted from outside the pool go on a shared queue.
+////////////////////////////////////////////////////////////////////////////
+class WorkStealingExecutor
+{
+public:
+  using Task = std::function< void() >;
+
+  WorkStealingExecutor(size_t nthreads = std::thread::hardware_concurrency())
+  {
+    nthreads = std::max< size_t >(nthreads, 1);
+    for (size_t i = 0; i < nthreads; i++) {
+      workers.push_back(std::make_unique< Worker >());
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+      workers[ i ]->thread = std::thread(&WorkStealingExecutor::run, this, (int) i);
+    }
+  }
+  //
+  // Stop the workers. Tasks that never got to run are dropped.
+  //
+  ~WorkStealingExecutor()
+  {
+    {
+      std::lock_guard< std::mutex > my_lock(sleep_mutex);
+      stopping = true;
+    }
+    my_condition_var.notify_all();
+    for (auto &w : workers) {
+      w->thread.join();
+    }
+    Task *task;
+    for (auto &w : workers) {
+      while (w->deque.take(task)) {
+        delete task;
+      }
+    }
+    for (auto task : injected) {
+      delete task;
+    }
+  }
+  WorkStealingExecutor(const WorkStealingExecutor &)            = delete;
+  WorkStealingExecutor &operator=(const WorkStealingExecutor &) = delete;
+
+  size_t size(void) const { return workers.size(); }
+
+  template < class F > void submit(F &&f)
+  {
+    auto task = new Task(std::forward< F >(f));
+    if (current == this) {
+      workers[ current_index ]->deque.push(task);
+    } else {
+      std::lock_guard< std::mutex > my_lock(injected_mutex);
+      injected.push_back(task);
+    }
+    wake();
+  }
+
+  //
+  // Run tasks on this thread until done() is true. Use this rather than
+  // blocking, so a worker waiting on other tasks helps run them.
+  //
+  template < class P > void run_until(P done)
+  {
+    auto self = (current == this) ? current_index : -1;
+    while (! done()) {
+      if (auto task = find_task(self)) {
+        (*task)();
+        delete task;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  //
+  // Call f(i) for every i in [begin, end). The range is split in half
+  // recursively, one half pushed as a task for someone to steal and the
+  // other half kept, until pieces are no bigger than grain.
+  //
+  template < class F > void parallel_for(size_t begin, size_t end, size_t grain, const F &f)
+  {
+    std::atomic< size_t > pending {1};
+    split(begin, end, std::max< size_t >(grain, 1), f, pending);
+    run_until([ & ] { return ! pending; });
+  }
+
+private:
+  struct Worker {
+    WorkStealingDeque< Task * > deque;
+    std::thread                 thread;
+  };
+
+  template < class F >
+  void split(size_t begin, size_t end, size_t grain, const F &f, std::atomic< size_t > &pending)
+  {
+    while (end - begin > grain) {
+      auto mid = begin + (end - begin) / 2;
+      pending++;
+      submit([ this, mid, end, grain, &f, &pending ] { split(mid, end, grain, f, pending); });
+      end = mid;
+    }
+    for (auto i = begin; i < end; i++) {
+      f(i);
+    }
+    pending--;
+  }
+
+  Task *find_task(int self)
+  {
+    Task *task;
+    if ((self >= 0) && workers[ self ]->deque.take(task)) {
+      return task;
+    }
+    {
+      std::lock_guard< std::mutex > my_lock(injected_mutex);
+      if (! injected.empty()) {
+        task = injected.front();
+        injected.pop_front();
+        return task;
+      }
+    }
+    //
+    // Try every other worker, starting from a random one
+    //
+    auto n     = workers.size();
+    auto start = random() % n;
+    for (size_t i = 0; i < n; i++) {
+      auto victim = (start + i) % n;
+      if (((int) victim != self) && workers[ victim ]->deque.steal(task)) {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  void run(int self)
+  {
+    current       = this;
+    current_index = self;
+
+    while (! stopping) {
+      auto seen = epoch.load();
+      //
+      // Spin a little before sleeping; new work often turns up quickly
+      //
+      Task *task = nullptr;
+      for (int spin = 0; ! task && (spin < 64); spin++) {
+        task = find_task(self);
+        if (! task) {
+          std::this_thread::yield();
+        }
+      }
+      if (task) {
+        (*task)();
+        delete task;
+        continue;
+      }
+      //
+      // Nothing anywhere. Sleep until someone submits more; epoch tells us
+      // if they did so after we last looked.
+      //
+      std::unique_lock< std::mutex > my_lock(sleep_mutex);
+      sleepers++;
+      my_condition_var.wait(my_lock, [ & ] { return stopping || (epoch.load() != seen); });
+      sleepers--;
+    }
+  }
+
+  void wake(void)
+  {
+    epoch++;
+    if (sleepers.load()) {
+      //
+      // Taking the lock means a worker cannot be between checking epoch
+      // and going to sleep, so it cannot miss this notify
+      //
+      { std::lock_guard< std::mutex > my_lock(sleep_mutex); }
+      my_condition_var.notify_one();
+    }
+  }
+
+  //
+  // A cheap per thread random number generator for picking victims
+  //
+  static uint32_t random(void)
+  {
+    static thread_local uint32_t seed = std::hash< std::thread::id >()(std::this_thread::get_id()) | 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+  }
+
+  std::vector< std::unique_ptr< Worker > > workers;
+  std::deque< Task * >                     injected;
+  std::mutex                               injected_mutex;
+  std::atomic< uint64_t >                  epoch {};
+  std::atomic< int >                       sleepers {};
+  std::atomic< bool >                      stopping {};
+  std::mutex                               sleep_mutex;
+  std::condition_variable                  my_condition_var;
+
+  inline static thread_local WorkStealingExecutor *current {};
+  inline static thread_local int                   current_index {-1};
+};
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::nano >(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const std::string &name, size_t ntasks, double ns)
+{
+  std::cout << std::left << std::setw(40) << name << std::right << std::setw(10) << ntasks << " tasks "
+            << std::setw(10) << std::fixed << std::setprecision(1) << ns / ntasks << " ns/task" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  size_t nthreads = std::thread::hardware_concurrency();
+  if (argc > 1) {
+    nthreads = std::atol(argv[ 1 ]);
+  }
+  WorkStealingExecutor executor(nthreads);
+
+  DOC("Start a pool of " << executor.size() << " workers and submit a task from outside");
+  {
+    std::atomic< bool > done {};
+    executor.submit([ & ] {
+      std::cout << "hello from a worker thread" << std::endl;
+      done = true;
+    });
+    executor.run_until([ & ] { return done.load(); });
+  }
+
+  DOC("Tasks can submit more tasks; they go on the submitting worker's own deque");
+  {
+    std::atomic< int > done {};
+    executor.submit([ & ] {
+      for (int i = 0; i < 10; i++) {
+        executor.submit([ & ] { done++; });
+      }
+    });
+    executor.run_until([ & ] { return done == 10; });
+    std::cout << "ran " << done << " child tasks" << std::endl;
+  }
+
+  DOC("Use parallel_for to sum a vector");
+  {
+    std::vector< int > data(10 * 1000 * 1000, 1);
+    std::atomic< long > total {};
+    executor.parallel_for(0, data.size() / 4096, 1, [ & ](size_t block) {
+      long sum = 0;
+      for (size_t i = block * 4096; i < (block + 1) * 4096; i++) {
+        sum += data[ i ];
+      }
+      total += sum;
+    });
+    for (size_t i = (data.size() / 4096) * 4096; i < data.size(); i++) {
+      total += data[ i ];
+    }
+    if (total == (long) data.size()) {
+      SUCCESS("sum is " << total);
+    } else {
+      FAILED("sum is " << total << " expected " << data.size());
+    }
+  }
+
+  DOC("Benchmark fine grained tasks");
+  {
+    static const size_t ntasks = 10000;
+    std::atomic< size_t > done {};
+    auto                  start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ntasks; i++) {
+      auto t = std::thread([ & ] { done++; });
+      t.join();
+    }
+    report("one std::thread per task", ntasks, elapsed_ns(start));
+  }
+  {
+    static const size_t   ntasks = 1000 * 1000;
+    std::atomic< size_t > done {};
+    auto                  start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ntasks; i++) {
+      executor.submit([ & ] { done++; });
+    }
+    executor.run_until([ & ] { return done == ntasks; });
+    report("submit from outside the pool", ntasks, elapsed_ns(start));
+  }
+  {
+    static const size_t   ntasks = 1000 * 1000;
+    std::atomic< size_t > done {};
+    auto                  start = std::chrono::steady_clock::now();
+    executor.submit([ & ] {
+      for (size_t i = 0; i < ntasks; i++) {
+        executor.submit([ & ] { done++; });
+      }
+    });
+    executor.run_until([ & ] { return done == ntasks; });
+    report("submit from a worker (fan out)", ntasks, elapsed_ns(start));
+  }
+  {
+    static const size_t   ntasks = 1000 * 1000;
+    std::atomic< size_t > done {};
+    auto                  start = std::chrono::steady_clock::now();
+    executor.parallel_for(0, ntasks, 1, [ & ](size_t) { done++; });
+    report("parallel_for, one task per element", ntasks, elapsed_ns(start));
+  }
+
+  DOC("End");
+  return 0;
+}
@@ -0,0 +1,294 @@
+#include "../common/common.h"
+#include <cerrno>
+#include <charconv> // std::to_chars
+#include <chrono>
+#include <cstdlib> // std::atol
+#include <functional>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <list>
+#include <numeric> // std::iota
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>        // open
+#include <sys/resource.h> // getrusage
+#include <sys/wait.h>     // waitpid
+#include <unistd.h>       // fork, write, close
+
+struct Foo {
+  Foo(int v) : value(v) {}
+
+public:
+  int value;
+};
+
+//
+// The std::to_chars backend from std_to_string_with_to_chars
+//
+template < typename T >
+static inline std::enable_if_t< std::is_arithmetic_v< T > && ! std::is_same_v< T, bool > >
+append_to_string(std::string &out, T v)
+{
+  //
+  // Long enough for any integer, or the shortest form of any double, e.g.
+  // -2.2250738585072014e-308
+  //
+  char buf[ 64 ];
+  auto end = std::to_chars(buf, buf + sizeof(buf), v).ptr;
+  out.append(buf, end - buf);
+}
+
+static inline void append_to_string(std::string &out, const Foo &f) { append_to_string(out, f.value); }
+
+template < class T, template < typename Elem, typename Allocator = std::allocator< Elem > > class C >
+static inline void append_to_string(std::string &out, const C< T > &elems)
+{
+  out += '[';
+  bool first = true;
+  for (const auto &elem : elems) {
+    if (! first) {
+      out += ", ";
+    }
+    first = false;
+    append_to_string(out, elem);
+  }
+  out += ']';
+}
+
+namespace std
+{
+std::string to_string(const struct Foo &f)
+{
+  std::string out;
+  append_to_string(out, f);
+  return out;
+}
+
+template < class T, template < typename Elem, typename Allocator = std::allocator< Elem > > class C >
+static inline const std::string to_string(const C< T > &elems)
+{
+  std::string out;
+  append_to_string(out, elems);
+  return out;
+}
+} // namespace std
+
+////////////////////////////////////////////////////////////////////////////
+// Write a container out a chunk at a time, instead of building all of it
+// in one string first.
+//
+// Text collects in a buffer of a fixed size. Whenever the buffer fills
+// past chunk_size, it is handed to a sink and cleared, keeping its memory
+// for the next chunk. So however large the container, the memory used is
+// one chunk plus the longest single element.
+//
+// A sink is anything that takes a std::string_view: a file descriptor, a
+// std::ostream, or a callback of your own.
+////////////////////////////////////////////////////////////////////////////
+using Sink = std::function< void(std::string_view) >;
+
+class ChunkedWriter
+{
+private:
+  std::string buf;
+  size_t      chunk_size;
+  Sink        sink;
+
+public:
+  ChunkedWriter(Sink sink, size_t chunk_size) : chunk_size(chunk_size), sink(std::move(sink))
+  {
+    buf.reserve(chunk_size + 64);
+  }
+
+  std::string &buffer(void) { return buf; }
+
+  void maybe_flush(void)
+  {
+    if (buf.size() >= chunk_size) {
+      flush();
+    }
+  }
+
+  void flush(void)
+  {
+    if (! buf.empty()) {
+      sink(buf);
+      buf.clear();
+    }
+  }
+};
+
+//
+// One value, written whole into the buffer
+//
+template < typename T > static inline void append_streaming(ChunkedWriter &w, const T &v)
+{
+  append_to_string(w.buffer(), v);
+  w.maybe_flush();
+}
+
+//
+// A container, one element at a time, so containers of containers are
+// chunked all the way down too
+//
+template < class T, template < typename Elem, typename Allocator = std::allocator< Elem > > class C >
+static inline void append_streaming(ChunkedWriter &w, const C< T > &elems)
+{
+  w.buffer() += '[';
+  bool first = true;
+  for (const auto &elem : elems) {
+    if (! first) {
+      w.buffer() += ", ";
+    }
+    first = false;
+    append_streaming(w, elem);
+  }
+  w.buffer() += ']';
+  w.maybe_flush();
+}
+
+//
+// The same text std::to_string would return, handed to sink in chunks of
+// about chunk_size bytes
+//
+template < typename T > static void to_string_stream(const T &v, Sink sink, size_t chunk_size = 64 * 1024)
+{
+  ChunkedWriter w(std::move(sink), chunk_size);
+  append_streaming(w, v);
+  w.flush();
+}
+
+//
+// Sinks for a file descriptor and a std::ostream
+//
+static Sink fd_sink(int fd)
+{
+  return [ fd ](std::string_view s) {
+    while (! s.empty()) {
+      auto n = ::write(fd, s.data(), s.size());
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::system_error(errno, std::generic_category(), "write");
+      }
+      s.remove_prefix(n);
+    }
+  };
+}
+
+static Sink ostream_sink(std::ostream &os)
+{
+  return [ &os ](std::string_view s) { os.write(s.data(), s.size()); };
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+static long peak_kb(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+//
+// Write v to /dev/null with dump, and report the time and how much the
+// peak memory of the process grew. Each run is in a child process of its
+// own, so each starts from the same peak.
+//
+template < class T, class Dump > static void bench(const std::string &name, const T &v, Dump dump)
+{
+  std::cout.flush();
+  auto pid = fork();
+  if (pid < 0) {
+    FAILED("fork failed");
+    return;
+  }
+  if (pid > 0) {
+    int status;
+    if ((waitpid(pid, &status, 0) < 0) || ! WIFEXITED(status) || WEXITSTATUS(status)) {
+      FAILED(name << " did not run to the end");
+    }
+    return;
+  }
+
+  auto fd = open("/dev/null", O_WRONLY);
+  if (fd < 0) {
+    FAILED("cannot open /dev/null");
+    _exit(1);
+  }
+
+  auto kb    = peak_kb();
+  auto start = std::chrono::steady_clock::now();
+  dump(v, fd);
+  auto ms = elapsed_ms(start);
+  kb      = peak_kb() - kb;
+  close(fd);
+
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << ms << " ms" << std::setw(10) << kb / 1024 << " MB more peak memory" << std::endl;
+  std::cout.flush();
+  _exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+  DOC("Stream std::vector<Foo> to std::cout");
+  std::vector< Foo > vector_of_foo;
+  vector_of_foo.push_back(Foo(6));
+  vector_of_foo.push_back(Foo(7));
+  vector_of_foo.push_back(Foo(8));
+  to_string_stream(vector_of_foo, ostream_sink(std::cout));
+  std::cout << std::endl;
+
+  DOC("Stream std::list<std::vector<double>> to file descriptor 1");
+  std::list< std::vector< double > > nested = {{0.1, 0.2}, {}, {1.0 / 3}};
+  std::cout.flush();
+  to_string_stream(nested, fd_sink(1));
+  std::cout << std::endl;
+
+  DOC("Stream std::vector<int> to a callback, in chunks of about 16 bytes");
+  std::vector< int > ints(20);
+  std::iota(ints.begin(), ints.end(), 1000);
+  to_string_stream(
+      ints, [](std::string_view chunk) { std::cout << "chunk \"" << chunk << "\"" << std::endl; }, 16);
+
+  DOC("The chunks join up to what std::to_string returns");
+  std::string joined;
+  to_string_stream(ints, [ & ](std::string_view chunk) { joined += chunk; }, 16);
+  if (joined == std::to_string(ints)) {
+    SUCCESS("same text");
+  } else {
+    FAILED("different text " << joined);
+  }
+
+  size_t n = 10 * 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Write " << n << " doubles to /dev/null");
+  std::mt19937                          rng(42);
+  std::lognormal_distribution< double > latencies(0.0, 2.0);
+  std::vector< double >                 metrics(n);
+  for (auto &m : metrics) {
+    m = latencies(rng);
+  }
+
+  bench("std::to_string, then write", metrics, [](const std::vector< double > &v, int fd) {
+    auto s = std::to_string(v);
+    fd_sink(fd)(s);
+  });
+  bench("to_string_stream, fd_sink", metrics,
+        [](const std::vector< double > &v, int fd) { to_string_stream(v, fd_sink(fd)); });
+
+  DOC("End");
+}
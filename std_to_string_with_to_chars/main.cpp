@@ -0,0 +1,221 @@
+#include "../common/common.h"
+#include <charconv> // std::to_chars, std::from_chars
+#include <chrono>
+#include <cstdlib> // std::atol
+#include <iomanip> // std::setw
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+struct Foo {
+  Foo(int v) : value(v) {}
+
+public:
+  int value;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// A formatting backend built on std::to_chars (C++17).
+//
+// std::to_chars writes a number into a char buffer you give it. It does
+// not allocate, does not look at the locale, and for float and double
+// with no format given, writes the shortest text that reads back as
+// exactly the same value.
+//
+// Each append_to_string() overload adds the text of one value to the end
+// of out. Nothing is returned, so a whole container is written into one
+// string, and that string can be cleared and used again for the next one
+// without giving back its memory.
+////////////////////////////////////////////////////////////////////////////
+template < typename T >
+static inline std::enable_if_t< std::is_arithmetic_v< T > && ! std::is_same_v< T, bool > >
+append_to_string(std::string &out, T v)
+{
+  //
+  // Long enough for any integer, or the shortest form of any double, e.g.
+  // -2.2250738585072014e-308
+  //
+  char buf[ 64 ];
+  auto end = std::to_chars(buf, buf + sizeof(buf), v).ptr;
+  out.append(buf, end - buf);
+}
+
+static inline void append_to_string(std::string &out, const Foo &f) { append_to_string(out, f.value); }
+
+template < class T, template < typename Elem, typename Allocator = std::allocator< Elem > > class C >
+static inline void append_to_string(std::string &out, const C< T > &elems)
+{
+  out += '[';
+  bool first = true;
+  for (const auto &elem : elems) {
+    if (! first) {
+      out += ", ";
+    }
+    first = false;
+    append_to_string(out, elem);
+  }
+  out += ']';
+}
+
+namespace std
+{
+std::string to_string(const struct Foo &f)
+{
+  std::string out;
+  append_to_string(out, f);
+  return out;
+}
+
+template < class T, template < typename Elem, typename Allocator = std::allocator< Elem > > class C >
+static inline const std::string to_string(const C< T > &elems)
+{
+  std::string out;
+  append_to_string(out, elems);
+  return out;
+}
+} // namespace std
+
+//
+// Like std::to_string, but into a string you already have, so that a
+// loop printing many containers reuses one buffer
+//
+template < class T > static inline const std::string &to_string_into(std::string &out, const T &v)
+{
+  out.clear();
+  append_to_string(out, v);
+  return out;
+}
+
+//
+// For comparison: the way std_to_string builds its output, with a new
+// std::string from std::to_string for every element
+//
+template < class T, template < typename Elem, typename Allocator = std::allocator< Elem > > class C >
+static const std::string concat_to_string(const C< T > &elems)
+{
+  std::string out = "[";
+  for (const auto &elem : elems) {
+    if (out.size() > 1) {
+      out += ", ";
+    }
+    out += std::to_string(elem);
+  }
+  out += "]";
+  return out;
+}
+
+//
+// Read the numbers back out of "[a, b, c]" and check they are what went
+// in, to the last bit
+//
+template < class T > static bool round_trips(const std::string &s, const std::vector< T > &expected)
+{
+  auto   p = s.data() + 1;
+  auto   e = s.data() + s.size() - 1;
+  size_t i = 0;
+  while (p < e) {
+    T v {};
+    auto [ next, ec ] = std::from_chars(p, e, v);
+    if ((ec != std::errc()) || (i >= expected.size()) || (v != expected[ i++ ])) {
+      return false;
+    }
+    p = next + 2; // skip ", "
+  }
+  return i == expected.size();
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+}
+
+template < class T > static void bench(const std::string &what, const std::vector< T > &v)
+{
+  const int   repeat = 5;
+  std::string out;
+
+  auto report = [ & ](const std::string &name, double ms) {
+    std::cout << std::left << std::setw(36) << (name + ", " + what) << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << ms / repeat << " ms" << std::setw(12) << out.size() << " chars" << std::endl;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; r++) {
+    out = concat_to_string(v);
+  }
+  report("concat_to_string", elapsed_ms(start));
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; r++) {
+    out = std::to_string(v);
+  }
+  report("std::to_string", elapsed_ms(start));
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; r++) {
+    to_string_into(out, v);
+  }
+  report("to_string_into", elapsed_ms(start));
+
+  if (! round_trips(out, v)) {
+    FAILED(what << " did not read back the same");
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  DOC("Print Foo");
+  Foo foo(99);
+  std::cout << "Single foo: " << std::to_string(foo) << std::endl;
+
+  DOC("Print std::list<Foo>");
+  std::list< Foo > list_of_foo;
+  list_of_foo.push_back(Foo(42));
+  list_of_foo.push_back(Foo(43));
+  std::cout << "List of foo: " << std::to_string(list_of_foo) << std::endl;
+
+  DOC("Print std::vector<Foo>");
+  std::vector< Foo > vector_of_foo;
+  vector_of_foo.push_back(Foo(6));
+  vector_of_foo.push_back(Foo(7));
+  vector_of_foo.push_back(Foo(8));
+  std::cout << "Vector of foo: " << std::to_string(vector_of_foo) << std::endl;
+
+  DOC("Print std::vector<double>, shortest form that reads back the same");
+  std::vector< double > doubles = {0.1, 1.0 / 3, 1e100, -2.5, 123456789.0};
+  std::cout << "Vector of double: " << std::to_string(doubles) << std::endl;
+  std::cout << "Old way:          " << concat_to_string(doubles) << std::endl;
+
+  DOC("Print std::vector<std::vector<int>>");
+  std::vector< std::vector< int > > nested = {{1, 2}, {}, {3}};
+  std::cout << "Nested: " << std::to_string(nested) << std::endl;
+
+  DOC("Print several vectors through one reused buffer");
+  std::string buffer;
+  for (int i = 1; i <= 3; i++) {
+    std::cout << to_string_into(buffer, std::vector< int >(i, i)) << std::endl;
+  }
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Print " << n << " metrics");
+  std::mt19937                          rng(42);
+  std::uniform_int_distribution< long > counts(0, 1000 * 1000 * 1000);
+  std::lognormal_distribution< double > latencies(0.0, 2.0);
+  std::vector< long >                   longs(n);
+  std::vector< double >                 doubles_n(n);
+  for (size_t i = 0; i < n; i++) {
+    longs[ i ]     = counts(rng);
+    doubles_n[ i ] = latencies(rng);
+  }
+  bench("long", longs);
+  bench("double", doubles_n);
+
+  DOC("End");
+}
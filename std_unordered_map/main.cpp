@@ -1,12 +1,53 @@
 #include "../common/common.h"
 #include <algorithm>
+#include <cstdlib> // std::malloc
+#include <functional>
 #include <iostream>
 #include <list>
 #include <map>
+#include <new>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
+//
+// Count trips to the heap, so we can see which lookups make them. Each
+// block carries a small header, so operator delete can find the start of
+// what malloc gave us.
+//
+static size_t heap_allocs;
+
+static const size_t heap_header = 16;
+
+void *operator new(std::size_t size)
+{
+  auto p = static_cast< char * >(std::malloc(size + heap_header));
+  if (! p) {
+    throw std::bad_alloc();
+  }
+  heap_allocs++;
+  return p + heap_header;
+}
+void operator delete(void *p) noexcept
+{
+  if (p) {
+    std::free(static_cast< char * >(p) - heap_header);
+  }
+}
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+
+//
+// A hash that takes a std::string, std::string_view or const char * alike.
+// is_transparent tells std::unordered_map (from C++20) that find() may pass
+// the caller's key straight through, rather than first making a temporary
+// std::string out of it. std::equal_to<> is already transparent.
+//
+struct StringHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const noexcept { return std::hash< std::string_view >()(s); }
+};
+
 static void std_unordered_map_sort(void)
 {
   DOC("std::unordered_map");
@@ -43,8 +84,44 @@ static void std_map_sort(void)
   }
 }
 
+static void transparent_lookup(void)
+{
+  //
+  // Long enough not to fit in std::string's small string buffer
+  //
+  const char *key = "Zaphod Beeblebrox, President of the Imperial Galactic Government";
+
+  DOC("Look up a long const char * key in a plain std::unordered_map");
+  {
+    std::unordered_map< std::string, int > m;
+    m[ key ]    = 1;
+    auto allocs = heap_allocs;
+    auto found  = m.find(key) != m.end();
+    std::cout << (found ? "found" : "not found") << " with " << heap_allocs - allocs << " allocation(s)" << std::endl;
+  }
+
+  DOC("Look up the same key with a transparent hash and std::equal_to<>");
+  {
+    std::unordered_map< std::string, int, StringHash, std::equal_to<> > m;
+    m[ key ]    = 1;
+    auto allocs = heap_allocs;
+    auto found  = (m.find(key) != m.end()) && (m.find(std::string_view(key)) != m.end());
+    std::cout << (found ? "found" : "not found") << " with " << heap_allocs - allocs << " allocation(s)" << std::endl;
+  }
+
+  DOC("Look up the same key in a std::map with std::less<>");
+  {
+    std::map< std::string, int, std::less<> > m;
+    m[ key ]    = 1;
+    auto allocs = heap_allocs;
+    auto found  = (m.find(key) != m.end()) && (m.find(std::string_view(key)) != m.end());
+    std::cout << (found ? "found" : "not found") << " with " << heap_allocs - allocs << " allocation(s)" << std::endl;
+  }
+}
+
 int main(int, char **)
 {
   std_map_sort();
   std_unordered_map_sort();
+  transparent_lookup();
 }
@@ -0,0 +1,337 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> // std::atol
+#include <functional>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// A key that works out its hash once, when it is made, and carries it
+// around. Containers that ask for the hash again (on every rehash, or to
+// check a probe) get the stored value instead of hashing the key again.
+//
+// The hash from Hash is also put through the splitmix64 finalizer, so that
+// every bit of the key affects every bit of the hash. That matters for
+// std::hash< int >, which is usually just the number itself.
+////////////////////////////////////////////////////////////////////////////
+template < class K, class Hash = std::hash< K > > class HashedKey
+{
+private:
+  K        key {};
+  uint64_t hash_value;
+
+  static uint64_t mix(uint64_t h)
+  {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+  }
+
+public:
+  HashedKey(void) : hash_value(mix(Hash()(key))) {}
+  HashedKey(const K &key) : key(key), hash_value(mix(Hash()(this->key))) {}
+  HashedKey(K &&key) : key(std::move(key)), hash_value(mix(Hash()(this->key))) {}
+  const K &get(void) const { return key; }
+  uint64_t hash(void) const { return hash_value; }
+
+  //
+  // Different hashes mean different keys, so that check comes first and
+  // is nearly always the only one needed for a miss
+  //
+  friend bool operator==(const HashedKey &lhs, const HashedKey &rhs)
+  {
+    return (lhs.hash_value == rhs.hash_value) && (lhs.key == rhs.key);
+  }
+  friend bool operator!=(const HashedKey &lhs, const HashedKey &rhs) { return ! (lhs == rhs); }
+  friend bool operator<(const HashedKey &lhs, const HashedKey &rhs) { return lhs.key < rhs.key; }
+  friend std::ostream &operator<<(std::ostream &os, const HashedKey &o)
+  {
+    os << o.key;
+    return os;
+  }
+};
+
+namespace std
+{
+template < class K, class Hash > struct hash< HashedKey< K, Hash > > {
+  size_t operator()(const HashedKey< K, Hash > &x) const noexcept { return x.hash(); }
+};
+} // namespace std
+
+////////////////////////////////////////////////////////////////////////////
+// The AccountNumber from std_map_with_custom_key, plus what it needs to be
+// a key in an unordered container: == and a std::hash.
+////////////////////////////////////////////////////////////////////////////
+class AccountNumber
+{
+private:
+  int val {};
+
+public:
+  AccountNumber(void) {}
+  AccountNumber(int val) : val(val) {}
+  int                  value(void) const { return val; }
+  bool                 operator<(const AccountNumber &rhs) const { return (val < rhs.val); }
+  bool                 operator==(const AccountNumber &rhs) const { return (val == rhs.val); }
+  std::string          to_string(void) const { return "AccountNumber(" + std::to_string(val) + ")"; }
+  friend std::ostream &operator<<(std::ostream &os, const AccountNumber &o)
+  {
+    os << o.to_string();
+    return os;
+  }
+};
+
+namespace std
+{
+template <> struct hash< AccountNumber > {
+  size_t operator()(const AccountNumber &x) const noexcept { return std::hash< int >()(x.value()); }
+};
+} // namespace std
+
+template < class T > class BankAccount;
+
+template < class T > class BankAccount
+{
+private:
+  T cash {};
+
+public:
+  BankAccount() { std::cout << "default constructor " << to_string() << std::endl; }
+  BankAccount(T cash) : cash(cash) { std::cout << "new cash " << to_string() << std::endl; }
+  BankAccount(const BankAccount &o)
+  {
+    std::cout << "copy cash constructor called for " << o.to_string() << std::endl;
+    cash = o.cash;
+    std::cout << "copy cash constructor result is  " << to_string() << std::endl;
+  }
+  ~BankAccount() { std::cout << "delete account " << to_string() << std::endl; }
+  void deposit(const T &deposit)
+  {
+    cash += deposit;
+    std::cout << "deposit cash called " << to_string() << std::endl;
+  }
+  using CheckTransactionCallback = std::function< void(T) >;
+  int check_transaction(int cash, CheckTransactionCallback fn)
+  {
+    if (cash < 100) {
+      throw std::string("transaction is too small for Mr Money Bags");
+    } else {
+      fn(cash);
+    }
+    return cash;
+  }
+  T    balance(void) const { return cash; }
+  bool check_balance(T expected) const
+  {
+    if (cash == expected) {
+      return true;
+    } else {
+      throw std::string("account has different funds " + to_string() + " than expected " + std::to_string(expected));
+    }
+  }
+  friend std::ostream &operator<<(std::ostream &os, const BankAccount< T > &o)
+  {
+    os << "$" << std::to_string(o.cash);
+    return os;
+  }
+  std::string to_string(void) const
+  {
+    auto              address = static_cast< const void              *>(this);
+    std::stringstream ss;
+    ss << address;
+    return "BankAccount(" + ss.str() + ", cash $" + std::to_string(cash) + ")";
+  }
+};
+
+template < class T > class BankCustomer;
+
+////////////////////////////////////////////////////////////////////////////
+// The BankCustomer from std_unordered_set, but the name is a HashedKey so
+// its hash is worked out once, when the customer is created.
+////////////////////////////////////////////////////////////////////////////
+template < class T > class BankCustomer
+{
+private:
+  HashedKey< std::string > name {};
+  BankAccount< T >         account;
+
+public:
+  BankCustomer(void) { std::cout << "default customer " << to_string() << std::endl; }
+  BankCustomer(const std::string &name) : name(name)
+  {
+    std::cout << "new temporary customer " << to_string() << std::endl;
+  }
+  BankCustomer(const std::string &name, const BankAccount< T > &account) : name(name), account(account)
+  {
+    std::cout << "new customer " << to_string() << std::endl;
+  }
+  ~BankCustomer() { std::cout << "delete customer " << to_string() << std::endl; }
+  std::string          to_string(void) const { return "Customer(" + name.get() + ", " + account.to_string() + ")"; }
+  const std::string   &get_name(void) const { return name.get(); }
+  uint64_t             hash(void) const { return name.hash(); }
+  friend std::ostream &operator<<(std::ostream &os, const BankCustomer< T > &o)
+  {
+    os << o.to_string();
+    return os;
+  }
+  friend bool operator==(const class BankCustomer< T > &lhs, const class BankCustomer< T > &rhs)
+  {
+    return lhs.name == rhs.name;
+  }
+  friend bool operator!=(const class BankCustomer< T > &lhs, const class BankCustomer< T > &rhs)
+  {
+    return lhs.name != rhs.name;
+  }
+};
+
+namespace std
+{
+template < class T > struct hash< BankCustomer< T > > {
+  size_t operator()(const BankCustomer< T > &x) const noexcept { return x.hash(); }
+};
+} // namespace std
+
+static void account_demo(void)
+{
+  DOC("Create a std::unordered_map of HashedKey< AccountNumber > -> Account");
+  using Account = BankAccount< int >;
+  using Bank    = std::unordered_map< HashedKey< AccountNumber >, Account >;
+  Bank thebank;
+
+  HashedKey< AccountNumber > account1(101);
+  HashedKey< AccountNumber > account2(102);
+  std::cout << account1 << " hash " << std::hex << account1.hash() << std::endl;
+  std::cout << account2 << " hash " << account2.hash() << std::dec << std::endl;
+
+  DOC("Add accounts with emplace()");
+  thebank.emplace(account1, 10000);
+  thebank.emplace(account2, 20000);
+
+  DOC("Does account1 exist?");
+  if (thebank.find(account1) == thebank.end()) {
+    FAILED("No");
+  } else {
+    SUCCESS("Yes");
+  }
+
+  DOC("Rob the bank");
+  thebank.clear();
+}
+
+static void customer_demo(void)
+{
+  DOC("Create a std::unordered_set of BankCustomer, hashed by name once only");
+  using Account  = BankAccount< int >;
+  using Customer = BankCustomer< int >;
+  using TheBank  = std::unordered_set< Customer >;
+
+  TheBank customers;
+  customers.insert(Customer("Arthur", Account(100)));
+  customers.insert(Customer("Zaphod", Account(100000)));
+  customers.insert(Customer("Marvin", Account(0)));
+
+  DOC("Find Zaphod via find");
+  auto f = customers.find(Customer("Zaphod"));
+  if (f != customers.end()) {
+    std::cout << *f << std::endl;
+  }
+
+  DOC("Get rid of all customers");
+  customers.clear();
+}
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::nano >(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Insert every key, timing each insert so we can see the worst ones (when
+// the table grows and every element is rehashed), then find every key
+//
+template < class Set, class Key >
+static void bench(const std::string &name, const std::vector< Key > &keys, bool reserve = false)
+{
+  Set  set;
+  auto n = keys.size();
+  if (reserve) {
+    set.reserve(n);
+  }
+
+  std::vector< double > insert_ns;
+  insert_ns.reserve(n);
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &k : keys) {
+    auto one = std::chrono::steady_clock::now();
+    set.insert(k);
+    insert_ns.push_back(elapsed_ns(one));
+  }
+  auto total_ns = elapsed_ns(start);
+  std::sort(insert_ns.begin(), insert_ns.end());
+
+  size_t found = 0;
+  start        = std::chrono::steady_clock::now();
+  for (const auto &k : keys) {
+    found += set.count(k);
+  }
+  auto find_ns = elapsed_ns(start) / n;
+
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << total_ns / n << std::setw(12) << insert_ns[ n - 1 ] / 1e6 << std::setw(10)
+            << find_ns << std::endl;
+  if (found != n) {
+    FAILED(name << " found " << found << " of " << n);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  account_demo();
+  customer_demo();
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  //
+  // Names long enough that hashing them is real work
+  //
+  DOC("Benchmark " << n << " customers with long names");
+  std::vector< std::string > names;
+  for (size_t i = 0; i < n; i++) {
+    names.push_back("Customer " + std::to_string(i) + " of the First Bank of Magrathea, Horsehead Nebula");
+  }
+  std::shuffle(names.begin(), names.end(), std::mt19937(42));
+
+  //
+  // The keys are hashed once, up front, as they would be when a customer
+  // record is first loaded
+  //
+  std::vector< HashedKey< std::string > > hashed(names.begin(), names.end());
+
+  std::cout << std::left << std::setw(36) << "" << std::right << std::setw(10) << "insert ns" << std::setw(12)
+            << "worst ms" << std::setw(10) << "find ns" << std::endl;
+  bench< std::unordered_set< std::string > >("std::string", names);
+  bench< std::unordered_set< HashedKey< std::string > > >("HashedKey< std::string >", hashed);
+
+  //
+  // When the final size is known, reserve() does the growing once, before
+  // anything is in the table, and no single insert pays for a rehash
+  //
+  bench< std::unordered_set< HashedKey< std::string > > >("HashedKey< std::string > + reserve", hashed, true);
+
+  DOC("End");
+}
@@ -0,0 +1,600 @@
+#include "../common/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> // std::malloc, std::atol
+#include <functional>
+#include <iomanip> // std::setw
+#include <iostream>
+#include <list>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// Keep a count of live heap bytes, so we can see what each set costs per
+// entry. Each block carries its size in a small header.
+////////////////////////////////////////////////////////////////////////////
+static size_t heap_bytes;
+
+static const size_t heap_header = 16;
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  auto p = static_cast< char * >(std::malloc(size + heap_header));
+  if (! p) {
+    return nullptr;
+  }
+  *reinterpret_cast< size_t * >(p) = size;
+  heap_bytes += size;
+  return p + heap_header;
+}
+void *operator new(std::size_t size)
+{
+  auto p = operator new(size, std::nothrow);
+  if (! p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete(void *p) noexcept
+{
+  if (p) {
+    auto base = static_cast< char * >(p) - heap_header;
+    heap_bytes -= *reinterpret_cast< size_t * >(base);
+    std::free(base);
+  }
+}
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+
+template < class T > class BankAccount;
+
+template < class T > class BankAccount
+{
+private:
+  T cash {};
+
+public:
+  BankAccount() { std::cout << "default constructor " << to_string() << std::endl; }
+  BankAccount(T cash) : cash(cash) { std::cout << "new cash " << to_string() << std::endl; }
+  BankAccount(const BankAccount &o)
+  {
+    std::cout << "copy cash constructor called for " << o.to_string() << std::endl;
+    cash = o.cash;
+    std::cout << "copy cash constructor result is  " << to_string() << std::endl;
+  }
+  ~BankAccount() { std::cout << "delete account " << to_string() << std::endl; }
+  void deposit(const T &deposit)
+  {
+    cash += deposit;
+    std::cout << "deposit cash called " << to_string() << std::endl;
+  }
+  using CheckTransactionCallback = std::function< void(T) >;
+  int check_transaction(int cash, CheckTransactionCallback fn)
+  {
+    if (cash < 100) {
+      throw std::string("transaction is too small for Mr Money Bags");
+    } else {
+      fn(cash);
+    }
+    return cash;
+  }
+  T    balance(void) const { return cash; }
+  bool check_balance(T expected) const
+  {
+    if (cash == expected) {
+      return true;
+    } else {
+      throw std::string("account has different funds " + to_string() + " than expected " + std::to_string(expected));
+    }
+  }
+  friend std::ostream &operator<<(std::ostream &os, const BankAccount< T > &o)
+  {
+    os << "$" << std::to_string(o.cash);
+    return os;
+  }
+  std::string to_string(void) const
+  {
+    auto              address = static_cast< const void              *>(this);
+    std::stringstream ss;
+    ss << address;
+    return "BankAccount(" + ss.str() + ", cash $" + std::to_string(cash) + ")";
+  }
+};
+
+template < class T > class BankCustomer;
+
+template < class T > class BankCustomer
+{
+private:
+  std::string      name {};
+  BankAccount< T > account;
+
+public:
+  BankCustomer(void) { std::cout << "default customer " << to_string() << std::endl; }
+  BankCustomer(const std::string &name) : name(name)
+  {
+    std::cout << "new temporary customer " << to_string() << std::endl;
+  }
+  BankCustomer(const std::string &name, const BankAccount< T > &account) : name(name), account(account)
+  {
+    std::cout << "new customer " << to_string() << std::endl;
+  }
+  ~BankCustomer() { std::cout << "delete customer " << to_string() << std::endl; }
+  std::string          to_string(void) const { return "Customer(" + name + ", " + account.to_string() + ")"; }
+  std::string          get_name(void) const { return name; }
+  friend std::ostream &operator<<(std::ostream &os, const BankCustomer< T > &o)
+  {
+    os << o.to_string();
+    return os;
+  }
+  friend bool operator==(const class BankCustomer< T > &lhs, const class BankCustomer< T > &rhs)
+  {
+    return lhs.name == rhs.name;
+  }
+  friend bool operator!=(const class BankCustomer< T > &lhs, const class BankCustomer< T > &rhs)
+  {
+    return lhs.name != rhs.name;
+  }
+  bool operator==(const class BankCustomer< T > &o) { return name == o.name; }
+  bool operator!=(const class BankCustomer< T > &o) { return name != o.name; }
+};
+
+namespace std
+{
+template < class T > struct hash< BankCustomer< T > > {
+  size_t operator()(const BankCustomer< T > &x) const noexcept { return std::hash< std::string >()(x.get_name()); }
+};
+} // namespace std
+
+////////////////////////////////////////////////////////////////////////////
+// An open addressing hash set in the style of Google's Swiss tables.
+//
+// Elements live directly in one flat array of slots; there is no node per
+// element. Alongside it is an array of one byte control codes, one per
+// slot: either "empty", or 7 bits taken from the element's hash. A lookup
+// loads 16 control bytes at once and, with a couple of SSE2 instructions,
+// finds which of those 16 slots might hold our element. Only those few
+// slots (usually none, or the one we want) are compared for real.
+//
+// Probing is linear: an element lives at the first free slot at or after
+// its home slot. That lets erase shift the elements after it back into
+// the hole (Knuth's algorithm R) instead of leaving a "deleted" marker,
+// so the table never fills up with tombstones however much churn there
+// is. The price is that erase invalidates iterators to other elements.
+////////////////////////////////////////////////////////////////////////////
+template < class T, class Hash = std::hash< T >, class KeyEqual = std::equal_to< T > > class SwissSet
+{
+private:
+  static constexpr size_t group_width = 16;
+  static constexpr int8_t empty_code  = -128;
+
+  //
+  // 16 control bytes, and which of them match a given code
+  //
+  struct Group {
+#ifdef __SSE2__
+    __m128i ctrl;
+
+    Group(const int8_t *p) : ctrl(_mm_loadu_si128(reinterpret_cast< const __m128i * >(p))) {}
+    uint32_t match(int8_t code) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(code))); }
+#else
+    const int8_t *ctrl;
+
+    Group(const int8_t *p) : ctrl(p) {}
+    uint32_t match(int8_t code) const
+    {
+      uint32_t bits = 0;
+      for (size_t i = 0; i < group_width; i++) {
+        bits |= (uint32_t) (ctrl[ i ] == code) << i;
+      }
+      return bits;
+    }
+#endif
+  };
+
+public:
+  class Iterator
+  {
+  public:
+    using value_type        = T;
+    using reference         = const T &;
+    using pointer           = const T *;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    Iterator(void) {}
+    Iterator(const SwissSet *set, size_t i) : set(set), i(i) { skip_empty(); }
+    reference operator*() const { return set->slots[ i ]; }
+    pointer   operator->() const { return &set->slots[ i ]; }
+    Iterator &operator++()
+    {
+      i++;
+      skip_empty();
+      return *this;
+    }
+    Iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool operator==(const Iterator &o) const { return i == o.i; }
+    bool operator!=(const Iterator &o) const { return i != o.i; }
+
+  private:
+    void skip_empty(void)
+    {
+      while ((i < set->capacity) && (set->ctrl[ i ] == empty_code)) {
+        i++;
+      }
+    }
+    const SwissSet *set {};
+    size_t          i {};
+  };
+
+  //
+  // Elements are immutable, as with std::unordered_set
+  //
+  using iterator       = Iterator;
+  using const_iterator = Iterator;
+
+  SwissSet(void) {}
+  ~SwissSet()
+  {
+    clear();
+    ::operator delete(slots);
+  }
+  SwissSet(const SwissSet &)            = delete;
+  SwissSet &operator=(const SwissSet &) = delete;
+
+  iterator begin(void) const { return iterator(this, 0); }
+  iterator end(void) const { return iterator(this, capacity); }
+  size_t   size(void) const { return nelems; }
+  bool     empty(void) const { return ! nelems; }
+
+  std::pair< iterator, bool > insert(const T &value) { return insert_value(value); }
+  std::pair< iterator, bool > insert(T &&value) { return insert_value(std::move(value)); }
+
+  template < class... Args > std::pair< iterator, bool > emplace(Args &&...args)
+  {
+    return insert_value(T(std::forward< Args >(args)...));
+  }
+
+  iterator find(const T &key) const { return iterator(this, find_index(key, hash_of(key))); }
+  size_t   count(const T &key) const { return find_index(key, hash_of(key)) != capacity; }
+
+  std::pair< iterator, iterator > equal_range(const T &key) const
+  {
+    auto first = find(key);
+    auto last  = first;
+    if (first != end()) {
+      ++last;
+    }
+    return std::make_pair(first, last);
+  }
+
+  size_t erase(const T &key)
+  {
+    auto i = find_index(key, hash_of(key));
+    if (i == capacity) {
+      return 0;
+    }
+    erase_index(i);
+    return 1;
+  }
+
+  void clear(void)
+  {
+    for (size_t i = 0; i < capacity; i++) {
+      if (ctrl[ i ] != empty_code) {
+        slots[ i ].~T();
+      }
+    }
+    std::fill(ctrl.begin(), ctrl.end(), empty_code);
+    nelems = 0;
+  }
+
+private:
+  //
+  // Mix the hash, as std::hash of an integer is often the integer itself.
+  // The top bits pick the home slot; the bottom 7 are the control code.
+  //
+  size_t hash_of(const T &key) const
+  {
+    uint64_t h = hasher(key);
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+  }
+  size_t home(size_t h) const { return (h >> 7) & (capacity - 1); }
+  static int8_t code(size_t h) { return h & 0x7f; }
+
+  //
+  // The first group_width - 1 control bytes are repeated after the end, so
+  // a group can be loaded from any slot without wrapping
+  //
+  void set_ctrl(size_t i, int8_t c)
+  {
+    ctrl[ i ] = c;
+    if (i < group_width - 1) {
+      ctrl[ capacity + i ] = c;
+    }
+  }
+
+  size_t find_index(const T &key, size_t h) const
+  {
+    if (! capacity) {
+      return capacity;
+    }
+    auto mask = capacity - 1;
+    for (auto pos = home(h);; pos = (pos + group_width) & mask) {
+      Group g(ctrl.data() + pos);
+      for (auto bits = g.match(code(h)); bits; bits &= bits - 1) {
+        auto i = (pos + __builtin_ctz(bits)) & mask;
+        if (equal(slots[ i ], key)) {
+          return i;
+        }
+      }
+      //
+      // An empty slot ends the run our key would have been in
+      //
+      if (g.match(empty_code)) {
+        return capacity;
+      }
+    }
+  }
+
+  size_t find_empty(size_t h) const
+  {
+    auto mask = capacity - 1;
+    for (auto pos = home(h);; pos = (pos + group_width) & mask) {
+      if (auto bits = Group(ctrl.data() + pos).match(empty_code)) {
+        return (pos + __builtin_ctz(bits)) & mask;
+      }
+    }
+  }
+
+  template < class V > std::pair< iterator, bool > insert_value(V &&value)
+  {
+    auto h = hash_of(value);
+    auto i = find_index(value, h);
+    if (i != capacity) {
+      return std::make_pair(iterator(this, i), false);
+    }
+    //
+    // Keep at most 7/8 full; probe runs get long after that
+    //
+    if ((nelems + 1) * 8 > capacity * 7) {
+      rehash(std::max(capacity * 2, group_width));
+    }
+    i = find_empty(h);
+    new (slots + i) T(std::forward< V >(value));
+    set_ctrl(i, code(h));
+    nelems++;
+    return std::make_pair(iterator(this, i), true);
+  }
+
+  void erase_index(size_t hole)
+  {
+    slots[ hole ].~T();
+    set_ctrl(hole, empty_code);
+    nelems--;
+
+    //
+    // Walk the rest of the run. Anything whose home is at or before the
+    // hole can move back into it, which leaves a new hole to fill.
+    //
+    auto mask = capacity - 1;
+    for (auto i = (hole + 1) & mask; ctrl[ i ] != empty_code; i = (i + 1) & mask) {
+      auto h = home(hash_of(slots[ i ]));
+      if (((i - h) & mask) >= ((i - hole) & mask)) {
+        new (slots + hole) T(std::move(slots[ i ]));
+        slots[ i ].~T();
+        set_ctrl(hole, ctrl[ i ]);
+        set_ctrl(i, empty_code);
+        hole = i;
+      }
+    }
+  }
+
+  void rehash(size_t newcapacity)
+  {
+    auto oldslots    = slots;
+    auto oldctrl     = std::move(ctrl);
+    auto oldcapacity = capacity;
+
+    slots    = static_cast< T * >(::operator new(sizeof(T) * newcapacity));
+    capacity = newcapacity;
+    ctrl.assign(capacity + group_width - 1, empty_code);
+
+    for (size_t i = 0; i < oldcapacity; i++) {
+      if (oldctrl[ i ] != empty_code) {
+        auto h = hash_of(oldslots[ i ]);
+        auto j = find_empty(h);
+        new (slots + j) T(std::move(oldslots[ i ]));
+        set_ctrl(j, code(h));
+        oldslots[ i ].~T();
+      }
+    }
+    ::operator delete(oldslots);
+  }
+
+  T                    *slots {};
+  std::vector< int8_t > ctrl;
+  size_t                capacity {};
+  size_t                nelems {};
+  Hash                  hasher;
+  KeyEqual              equal;
+};
+
+static void insert_test(void)
+{
+  DOC("Default set");
+  SwissSet< std::string > m;
+
+  m.insert("zaphod");
+  m.insert("universe");
+  m.insert("arthur");
+  m.insert("marvin");
+  m.insert("mice");
+  m.insert("vogon");
+
+  for (auto i : m) {
+    std::cout << i << std::endl;
+  }
+}
+
+static void account_demo(void)
+{
+  DOC("Create a SwissSet of BankCustomer -> Account");
+  using Account  = BankAccount< int >;
+  using Customer = BankCustomer< int >;
+  using TheBank  = SwissSet< Customer >;
+
+  //
+  // Notice, Zaphod tries to open two accounts, but the set only allows one
+  //
+  TheBank customers;
+  customers.insert(Customer("Arthur", Account(100)));
+  customers.insert(Customer("Zaphod", Account(100000)));
+  if (! customers.insert(Customer("Zaphod", Account(999999))).second) {
+    DOC("Someone (Zaphod, let's face it) tried to add a 2nd account!");
+  }
+  customers.insert(Customer("Marvin", Account(0)));
+  customers.insert(Customer("TheMice", Account(666)));
+  customers.insert(Customer("Ford", Account(10)));
+
+  DOC("All customers, in no particular order");
+  for (const auto &b : customers) {
+    std::cout << b << std::endl;
+  }
+
+  DOC("Find Zaphod via find");
+  auto f = customers.find(Customer("Zaphod"));
+  if (f != customers.end()) {
+    std::cout << *f << std::endl;
+  }
+
+  DOC("Find customers via equal_range");
+  for (const auto &customer : customers) {
+    using Iter                  = TheBank::iterator;
+    std::pair< Iter, Iter > ret = customers.equal_range(customer);
+    for (auto iter = ret.first; iter != ret.second; iter++) {
+      std::cout << *iter << std::endl;
+    }
+  }
+
+  DOC("Get rid of a customer");
+  customers.erase(Customer("Zaphod"));
+
+  DOC("Get rid of all customers");
+  customers.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// A customer that does not log, for the benchmark
+////////////////////////////////////////////////////////////////////////////
+struct QuietCustomer {
+  std::string name;
+  long        cash {};
+
+  bool operator==(const QuietCustomer &o) const { return name == o.name; }
+};
+
+namespace std
+{
+template <> struct hash< QuietCustomer > {
+  size_t operator()(const QuietCustomer &x) const noexcept { return std::hash< std::string >()(x.name); }
+};
+} // namespace std
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration< double, std::nano >(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Insert every customer, look each one up, look up some strangers who are
+// not there, then erase everyone. Lookups and erases are in a different
+// order to the inserts.
+//
+template < class Set >
+static void bench(const std::string &name, const std::vector< QuietCustomer > &customers,
+                  const std::vector< QuietCustomer > &shuffled, const std::vector< QuietCustomer > &strangers)
+{
+  auto n     = customers.size();
+  auto bytes = heap_bytes;
+  Set  set;
+
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &c : customers) {
+    set.insert(c);
+  }
+  auto insert_ns = elapsed_ns(start) / n;
+  auto per_entry = (double) (heap_bytes - bytes) / n;
+
+  size_t found = 0;
+  start        = std::chrono::steady_clock::now();
+  for (const auto &c : shuffled) {
+    found += set.count(c);
+  }
+  auto hit_ns = elapsed_ns(start) / n;
+
+  size_t found_strangers = 0;
+  start                  = std::chrono::steady_clock::now();
+  for (const auto &c : strangers) {
+    found_strangers += set.count(c);
+  }
+  auto miss_ns = elapsed_ns(start) / n;
+
+  size_t erased = 0;
+  start         = std::chrono::steady_clock::now();
+  for (const auto &c : shuffled) {
+    erased += set.erase(c);
+  }
+  auto erase_ns = elapsed_ns(start) / n;
+
+  std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << insert_ns << std::setw(10) << hit_ns << std::setw(10) << miss_ns << std::setw(10) << erase_ns
+            << std::setw(14) << per_entry << std::endl;
+
+  if ((found != n) || found_strangers || (erased != n) || ! set.empty()) {
+    FAILED(name << " found " << found << " customers and " << found_strangers << " strangers, erased " << erased);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  insert_test();
+  account_demo();
+
+  size_t n = 1000 * 1000;
+  if (argc > 1) {
+    n = std::atol(argv[ 1 ]);
+  }
+
+  DOC("Benchmark " << n << " customers, times in ns per operation");
+  std::vector< QuietCustomer > customers;
+  std::vector< QuietCustomer > strangers;
+  for (size_t i = 0; i < n; i++) {
+    customers.push_back(QuietCustomer {"customer" + std::to_string(i), (long) i});
+    strangers.push_back(QuietCustomer {"stranger" + std::to_string(i), (long) i});
+  }
+  auto shuffled = customers;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+  std::cout << std::left << std::setw(28) << "" << std::right << std::setw(10) << "insert" << std::setw(10) << "find"
+            << std::setw(10) << "miss" << std::setw(10) << "erase" << std::setw(14) << "bytes/entry" << std::endl;
+  bench< std::unordered_set< QuietCustomer > >("std::unordered_set", customers, shuffled, strangers);
+  bench< SwissSet< QuietCustomer > >("SwissSet", customers, shuffled, strangers);
+
+  DOC("End");
+}